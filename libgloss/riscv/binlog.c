@@ -0,0 +1,70 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * Deferred-formatting logging, see <machine/binlog.h> for the record
+ * format.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <machine/binlog.h>
+#include "uart8250.h"
+
+/* Bounds of the format string section, provided by the linker */
+extern const char __start_binlog_fmt[] __attribute__((weak));
+extern const char __stop_binlog_fmt[] __attribute__((weak));
+
+/* Sync byte, length byte and up to 10 bytes per ULEB128 value */
+#define BINLOG_RECORD_MAX	(2 + 10 * (1 + BINLOG_MAX_ARGS))
+
+static unsigned char *
+binlog_uleb128(unsigned char *p, uint64_t v)
+{
+  do
+    {
+      *p = v & 0x7f;
+      v >>= 7;
+      if (v) *p |= 0x80;
+      p++;
+    }
+  while (v);
+
+  return p;
+}
+
+static void
+binlog_send(uint64_t id, unsigned int nargs, const int64_t *args)
+{
+  unsigned char record[BINLOG_RECORD_MAX];
+  unsigned char *p = record + 2;
+  int64_t v;
+
+  if (nargs > BINLOG_MAX_ARGS) nargs = BINLOG_MAX_ARGS;
+
+  p = binlog_uleb128(p, id);
+  while (nargs--)
+  {
+    v = *args++;
+    /* Zigzag, so that small negative values stay short */
+    p = binlog_uleb128(p, ((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+  }
+
+  record[0] = BINLOG_SYNC;
+  record[1] = p - record - 2;
+  uart8250_enqueue((const char*)record, p - record);
+}
+
+void
+__binlog_emit(const char *fmt, unsigned int nargs, const int64_t *args)
+{
+  binlog_send(fmt - __start_binlog_fmt + 1, nargs, args);
+}
+
+void
+binlog_init(void)
+{
+  int64_t size = __stop_binlog_fmt - __start_binlog_fmt;
+
+  /* Stay silent in programs that do not use binlog */
+  if (size > 0) binlog_send(0, 1, &size);
+}
@@ -0,0 +1,80 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * Boot support for crt0, see <machine/boot.h>.
+ *
+ * __data_lz4_decode runs before .data and .bss are set up, so it must
+ * only use its arguments, the stack and memcpy.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <machine/boot.h>
+#include "console.h"
+
+unsigned long boot_cycles[BOOT_STAMPS];
+
+/*
+ * Size of the LZ4 block at _data_load, or 0 when the .data image is
+ * stored as is. tools/lz4data.py patches it in the linked program, so it
+ * is kept in .rodata, where the compiler cannot see its final value.
+ */
+const uint32_t __data_lz4_size __attribute__((section(".rodata"))) = 0;
+
+/* Expand the LZ4 block (no frame header) of len bytes at src to dst */
+void
+__data_lz4_decode(unsigned char *dst, const unsigned char *src, size_t len)
+{
+  const unsigned char *end = src + len;
+  const unsigned char *match;
+  size_t n;
+  unsigned int token, c;
+
+  while (src < end)
+  {
+    token = *src++;
+
+    /* Literals */
+    n = token >> 4;
+    if (n == 15)
+      do
+        n += c = *src++;
+      while (c == 255);
+    memcpy(dst, src, n);
+    dst += n;
+    src += n;
+    if (src >= end)
+      break;			/* The last sequence has no match */
+
+    /* Match, which may overlap the bytes it produces */
+    match = dst - (src[0] | (src[1] << 8));
+    src += 2;
+    n = token & 15;
+    if (n == 15)
+      do
+        n += c = *src++;
+      while (c == 255);
+    n += 4;
+    while (n--)
+      *dst++ = *match++;
+  }
+}
+
+void
+boot_report(void)
+{
+  static const char *const names[BOOT_STAMPS] = {
+    "boot", " early ", " data ", " bss ", " init ", " main ",
+  };
+  int i;
+
+  console_puts(names[0]);
+  for (i = BOOT_EARLY; i < BOOT_STAMPS; i++)
+  {
+    console_puts(names[i]);
+    console_putu(boot_cycles[i] - boot_cycles[i - 1]);
+  }
+  console_puts(" total ");
+  console_putu(boot_cycles[BOOT_MAIN] - boot_cycles[BOOT_ENTER]);
+  console_puts("\n");
+}
@@ -0,0 +1,49 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * Register layout of the RISC-V Core-Local Interruptor: the per-hart
+ * software interrupt (MSIP) and timer compare registers and the shared
+ * mtime counter.
+ *
+ * The base address is a build-time setting (CLINT_BASE), the default
+ * follows the SiFive layout.
+ */
+
+#ifndef _RISCV_CLINT_H
+#define _RISCV_CLINT_H
+
+#include <stdint.h>
+
+#ifndef CLINT_BASE
+#define CLINT_BASE			0x02000000UL
+#endif
+
+#define CLINT_MSIP_OFFSET		0x0000
+#define CLINT_MTIMECMP_OFFSET	0x4000
+#define CLINT_MTIME_OFFSET		0xBFF8
+
+#define CLINT_MSIP(hart) \
+  (*(volatile uint32_t *)(CLINT_BASE + CLINT_MSIP_OFFSET + 4 * (hart)))
+#define CLINT_MTIMECMP(hart) \
+  (*(volatile uint64_t *)(CLINT_BASE + CLINT_MTIMECMP_OFFSET + 8 * (hart)))
+#define CLINT_MTIME \
+  (*(volatile uint64_t *)(CLINT_BASE + CLINT_MTIME_OFFSET))
+
+/* Program the timer compare register of a hart. On RV32 the high word
+   is parked at its maximum while the low word changes, so the comparator
+   never matches an intermediate value.  */
+static inline void
+clint_set_timer(unsigned long hart, uint64_t when)
+{
+#if __riscv_xlen == 32
+  volatile uint32_t *cmp = (volatile uint32_t *)&CLINT_MTIMECMP(hart);
+
+  cmp[1] = 0xFFFFFFFF;
+  cmp[0] = (uint32_t)when;
+  cmp[1] = (uint32_t)(when >> 32);
+#else
+  CLINT_MTIMECMP(hart) = when;
+#endif
+}
+
+#endif /* _RISCV_CLINT_H */
@@ -0,0 +1,90 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * Minimal console output, see console.h.
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include "console.h"
+
+void
+console_puts(const char *s)
+{
+  write(STDOUT_FILENO, s, strlen(s));
+}
+
+char *
+console_utoa(char *end, uint64_t v)
+{
+  do
+  {
+    *--end = '0' + v % 10;
+    v /= 10;
+  } while (v != 0);
+
+  return end;
+}
+
+void
+console_putu(uint64_t v)
+{
+  char digits[20];
+  char *p = console_utoa(digits + sizeof(digits), v);
+
+  write(STDOUT_FILENO, p, digits + sizeof(digits) - p);
+}
+
+void
+console_field(const char *s, size_t width, int right)
+{
+  static const char spaces[] = "                ";
+  size_t len = s != NULL ? strlen(s) : 0;
+  size_t pad, n;
+
+  if (len > width)
+    len = width;
+  pad = width - len;
+
+  if (!right)
+    write(STDOUT_FILENO, s, len);
+  for (; pad != 0; pad -= n)
+  {
+    n = pad < sizeof(spaces) - 1 ? pad : sizeof(spaces) - 1;
+    write(STDOUT_FILENO, spaces, n);
+  }
+  if (right)
+    write(STDOUT_FILENO, s, len);
+}
+
+void
+console_fieldu(uint64_t v, size_t width)
+{
+  char digits[21];
+
+  digits[20] = '\0';
+  console_field(console_utoa(digits + 20, v), width, 1);
+}
+
+void
+console_hex(const void *data, size_t len)
+{
+  static const char hex[] = "0123456789abcdef";
+  const unsigned char *bytes = data;
+  char line[2 * 32 + 1];
+  size_t i, n;
+  char *p;
+
+  for (i = 0; i < len; i += n)
+  {
+    n = len - i < 32 ? len - i : 32;
+    p = line;
+    for (size_t j = 0; j < n; j++)
+    {
+      *p++ = hex[bytes[i + j] >> 4];
+      *p++ = hex[bytes[i + j] & 0xF];
+    }
+    *p++ = '\n';
+    write(STDOUT_FILENO, line, p - line);
+  }
+}
@@ -0,0 +1,33 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * Minimal console output for the diagnostic parts of libgloss (profiler
+ * and trace dumps, exit statistics). Everything goes through write() to
+ * stdout, so it follows the console backend in use (UART or trace
+ * buffer), and nothing depends on printf or on the stdio buffers of the
+ * program being measured.
+ */
+
+#ifndef _RISCV_CONSOLE_H
+#define _RISCV_CONSOLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+void console_puts(const char *s);
+
+/* Unsigned decimal number */
+void console_putu(uint64_t v);
+
+/* Table columns: s or v padded with spaces to width, s left-aligned
+   unless right is set, numbers right-aligned */
+void console_field(const char *s, size_t width, int right);
+void console_fieldu(uint64_t v, size_t width);
+
+/* Decimal digits of v, stored backwards from end; returns the first */
+char *console_utoa(char *end, uint64_t v);
+
+/* len bytes as lowercase hex, 32 bytes per line */
+void console_hex(const void *data, size_t len);
+
+#endif /* _RISCV_CONSOLE_H */
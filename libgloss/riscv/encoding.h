@@ -0,0 +1,79 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * Machine-mode CSR bits and accessors used by the Headsail libgloss port.
+ */
+
+#ifndef _RISCV_ENCODING_H
+#define _RISCV_ENCODING_H
+
+#define MSTATUS_MIE		0x00000008
+#define MSTATUS_MPIE	0x00000080
+
+#define MIP_MSIP		(1 << IRQ_M_SOFT)
+#define MIP_MTIP		(1 << IRQ_M_TIMER)
+#define MIP_MEIP		(1 << IRQ_M_EXT)
+
+#define IRQ_M_SOFT		3
+#define IRQ_M_TIMER		7
+#define IRQ_M_EXT		11
+
+#define MCAUSE_INT		(1UL << (__riscv_xlen - 1))
+
+#ifndef __ASSEMBLER__
+
+#define read_csr(reg) ({ unsigned long __tmp; \
+  __asm__ volatile ("csrr %0, " #reg : "=r"(__tmp)); \
+  __tmp; })
+
+#define write_csr(reg, val) ({ \
+  __asm__ volatile ("csrw " #reg ", %0" :: "rK"(val)); })
+
+#define set_csr(reg, bit) ({ unsigned long __tmp; \
+  __asm__ volatile ("csrrs %0, " #reg ", %1" : "=r"(__tmp) : "rK"(bit)); \
+  __tmp; })
+
+#define clear_csr(reg, bit) ({ unsigned long __tmp; \
+  __asm__ volatile ("csrrc %0, " #reg ", %1" : "=r"(__tmp) : "rK"(bit)); \
+  __tmp; })
+
+/* Mask machine interrupts, returning the previous mstatus.MIE */
+static inline unsigned long
+irq_save(void)
+{
+  return clear_csr(mstatus, MSTATUS_MIE) & MSTATUS_MIE;
+}
+
+static inline void
+irq_restore(unsigned long flags)
+{
+  if (flags)
+    set_csr(mstatus, MSTATUS_MIE);
+}
+
+/* Test-and-test-and-set lock for libgloss state shared between harts.
+   Cores without atomics have a single hart, there it does nothing.  */
+static inline void
+spin_lock(int *lock)
+{
+#ifdef __riscv_atomic
+  while (__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE))
+    while (__atomic_load_n(lock, __ATOMIC_RELAXED));
+#else
+  (void)lock;
+#endif
+}
+
+static inline void
+spin_unlock(int *lock)
+{
+#ifdef __riscv_atomic
+  __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+#else
+  (void)lock;
+#endif
+}
+
+#endif /* __ASSEMBLER__ */
+
+#endif /* _RISCV_ENCODING_H */
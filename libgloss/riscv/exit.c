@@ -0,0 +1,79 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * _exit and the reporting of the exit status, see <machine/exit.h>.
+ */
+
+#include <stdint.h>
+#include <machine/cycles.h>
+#include <machine/exit.h>
+#include <machine/uart.h>
+#include "console.h"
+#include "hostio.h"
+#include "htif.h"
+
+__attribute__((weak))
+const struct exit_config exit_config = {
+  .method	= EXIT_LOOP,
+  .base		= 0,
+  .counters	= 0,
+};
+
+static void
+exit_counters(int status, uint64_t cycles, uint64_t instret)
+{
+  console_puts("exit ");
+  if (status < 0)
+  {
+    console_puts("-");
+    console_putu(-(int64_t)status);
+  }
+  else
+    console_putu(status);
+  console_puts(" mcycle ");
+  console_putu(cycles);
+  console_puts(" minstret ");
+  console_putu(instret);
+  console_puts("\n");
+}
+
+// No reentrant version of this exists
+void
+_exit(int exit_status)
+{
+  const struct exit_config *config = &exit_config;
+  volatile uint32_t *dev = (volatile uint32_t *)config->base;
+
+  /* Read first, so that the report itself is not counted */
+  if (config->counters)
+    exit_counters(exit_status, cycles_read(), instret_read());
+
+  /* Do not lose output still sitting in the transmit ring */
+  uart_flush();
+
+#ifdef USING_HOSTIO
+  hostio_exit(exit_status);
+#endif
+
+  switch (config->method)
+  {
+    case EXIT_FINISHER:
+      if (dev)
+        *dev = exit_status == 0 ? EXIT_FINISHER_PASS
+               : ((uint32_t)exit_status << 16) | EXIT_FINISHER_FAIL;
+      break;
+    case EXIT_HTIF:
+      htif_tohost(((uint64_t)(unsigned int)exit_status << 1) | 1);
+      break;
+    case EXIT_MAILBOX:
+      if (dev)
+      {
+        dev[0] = exit_status;
+        __asm__ volatile ("fence w,w" ::: "memory");
+        dev[1] = EXIT_MAILBOX_DONE;
+      }
+      break;
+  }
+
+  while (1);
+}
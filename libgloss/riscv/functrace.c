@@ -0,0 +1,163 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * Function entry/exit tracer for -finstrument-functions, see
+ * <machine/functrace.h>.
+ *
+ * Each hart appends to its own buffer, selected by mhartid, so no lock is
+ * taken. Interrupts are masked while a record is written, in case an
+ * instrumented interrupt handler traces on the same hart. Nothing in
+ * this file may itself be instrumented.
+ */
+
+#include <stdlib.h>
+#include <machine/cycles.h>
+#include <machine/functrace.h>
+#include "console.h"
+#include "encoding.h"
+
+#define NO_TRACE __attribute__((no_instrument_function))
+
+struct functrace __functrace[FUNCTRACE_HARTS];
+
+__attribute__((weak))
+const int functrace_console = 1;
+
+static volatile int functrace_on = 1;
+
+static inline uint8_t * NO_TRACE
+put_uleb128(uint8_t *p, uint64_t v)
+{
+  while (v >= 0x80)
+  {
+    *p++ = (uint8_t)v | 0x80;
+    v >>= 7;
+  }
+  *p++ = (uint8_t)v;
+  return p;
+}
+
+static inline void NO_TRACE
+functrace_record(uintptr_t fn, unsigned int exit)
+{
+  uint64_t cycle = cycles_read();
+  unsigned long hartid = read_csr(mhartid);
+  struct functrace *t;
+  unsigned long flags;
+  uintptr_t zigzag;
+  intptr_t delta;
+  uint8_t *p;
+
+  if (!functrace_on || hartid >= FUNCTRACE_HARTS)
+    return;
+
+  t = &__functrace[hartid];
+  flags = irq_save();
+
+  if (t->magic != FUNCTRACE_MAGIC)
+  {
+    t->magic = FUNCTRACE_MAGIC;
+    t->size = FUNCTRACE_SIZE;
+    t->start = t->last_cycle = cycle;
+  }
+
+  /* Two ULEB128 values of at most 10 bytes each */
+  if (t->size - t->used < 20)
+  {
+    t->dropped++;
+    irq_restore(flags);
+    return;
+  }
+
+  /* Zigzag-encode the signed distance to the previous function. On RV64
+     the exit bit pushes out the top bit of the zigzag value, so the
+     distance must stay below 2^62 bytes, which any real program does */
+  delta = (intptr_t)(fn - t->last_fn);
+  zigzag = ((uintptr_t)delta << 1) ^ (uintptr_t)(delta >> (__riscv_xlen - 1));
+
+  p = t->data + t->used;
+  p = put_uleb128(p, ((uint64_t)zigzag << 1) | exit);
+  p = put_uleb128(p, cycle - t->last_cycle);
+  t->used = p - t->data;
+  t->last_fn = fn;
+  t->last_cycle = cycle;
+
+  irq_restore(flags);
+}
+
+void NO_TRACE
+__cyg_profile_func_enter(void *fn, void *call_site)
+{
+  functrace_record((uintptr_t)fn, 0);
+}
+
+void NO_TRACE
+__cyg_profile_func_exit(void *fn, void *call_site)
+{
+  functrace_record((uintptr_t)fn, 1);
+}
+
+void NO_TRACE
+functrace_enable(int on)
+{
+  functrace_on = on;
+}
+
+void NO_TRACE
+functrace_reset(void)
+{
+  unsigned long hartid = read_csr(mhartid);
+  unsigned long flags;
+
+  if (hartid >= FUNCTRACE_HARTS)
+    return;
+
+  flags = irq_save();
+  __functrace[hartid].magic = FUNCTRACE_MAGIC;
+  __functrace[hartid].size = FUNCTRACE_SIZE;
+  __functrace[hartid].used = 0;
+  __functrace[hartid].dropped = 0;
+  __functrace[hartid].start = __functrace[hartid].last_cycle = cycles_read();
+  __functrace[hartid].last_fn = 0;
+  irq_restore(flags);
+}
+
+void NO_TRACE
+functrace_dump(void)
+{
+  unsigned int hart;
+  struct functrace *t;
+
+  for (hart = 0; hart < FUNCTRACE_HARTS; hart++)
+  {
+    t = &__functrace[hart];
+    if (t->magic != FUNCTRACE_MAGIC)
+      continue;
+
+    console_puts("\n--- functrace hart ");
+    console_putu(hart);
+    console_puts(" start ");
+    console_putu(t->start);
+    console_puts(" dropped ");
+    console_putu(t->dropped);
+    console_puts(" bytes ");
+    console_putu(t->used);
+    console_puts(" ---\n");
+    console_hex(t->data, t->used);
+    console_puts("--- end functrace ---\n");
+  }
+}
+
+static void NO_TRACE
+functrace_exit(void)
+{
+  functrace_on = 0;
+  if (functrace_console)
+    functrace_dump();
+}
+
+static void NO_TRACE __attribute__((constructor))
+functrace_init(void)
+{
+  atexit(functrace_exit);
+}
@@ -0,0 +1,150 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * PC-sampling profiler, see <machine/gmon.h>.
+ *
+ * The histogram is allocated in place inside the gmon.out image, right
+ * after the file and histogram record headers, so producing the image
+ * at exit only means filling in the headers. The headers have an odd
+ * length, so the image starts one byte into the allocation to keep the
+ * 16-bit bins aligned.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <machine/cycles.h>
+#include <machine/gmon.h>
+#include "console.h"
+#include "encoding.h"
+#include "timer.h"
+
+#define GMON_MAGIC			"gmon"
+#define GMON_VERSION		1
+#define GMON_TAG_TIME_HIST	0
+
+/* Bytes of text covered by one histogram bin */
+#define GMON_BIN_SIZE		4
+
+/* File header: cookie, version, 12 spare bytes */
+#define GMON_HDR_SIZE		20
+/* Histogram record: tag, low and high pc, size, rate, dimension */
+#define GMON_HIST_HDR_SIZE	(1 + 2 * sizeof(void *) + 4 + 4 + 15 + 1)
+#define GMON_HEADERS		(GMON_HDR_SIZE + GMON_HIST_HDR_SIZE)
+
+__attribute__((weak))
+const unsigned long gmon_rate = 1000;
+
+__attribute__((weak))
+const int gmon_console = 1;
+
+char *__gmon_image;
+size_t __gmon_image_size;
+
+static char *gmon_buffer;
+static uint16_t *gmon_hist;
+static unsigned long gmon_lowpc, gmon_highpc;
+static size_t gmon_bins;
+static volatile int gmon_on;
+
+/* Timer tick on the profiled hart */
+static void
+gmon_sample(uintptr_t pc)
+{
+  size_t bin = (pc - gmon_lowpc) / GMON_BIN_SIZE;
+
+  if (gmon_on && bin < gmon_bins && gmon_hist[bin] != UINT16_MAX)
+    gmon_hist[bin]++;
+}
+
+void
+monstartup(unsigned long lowpc, unsigned long highpc)
+{
+  char *buffer;
+
+  lowpc &= ~(unsigned long)(GMON_BIN_SIZE - 1);
+  highpc = (highpc + GMON_BIN_SIZE - 1) & ~(unsigned long)(GMON_BIN_SIZE - 1);
+  if (highpc <= lowpc)
+    return;
+
+  moncontrol(0);
+  free(gmon_buffer);
+  gmon_buffer = NULL;
+  gmon_hist = NULL;
+  __gmon_image = NULL;
+  __gmon_image_size = 0;
+
+  gmon_bins = (highpc - lowpc) / GMON_BIN_SIZE;
+  buffer = calloc(1 + GMON_HEADERS + gmon_bins * sizeof(uint16_t), 1);
+  if (buffer == NULL)
+  {
+    write(STDERR_FILENO, "monstartup: out of memory\n", 26);
+    return;
+  }
+
+  gmon_buffer = buffer;
+  __gmon_image = buffer + (GMON_HEADERS & 1);
+  gmon_hist = (uint16_t *)(__gmon_image + GMON_HEADERS);
+  gmon_lowpc = lowpc;
+  gmon_highpc = highpc;
+
+  timer_tick(timebase_freq / gmon_rate, gmon_sample);
+  set_csr(mstatus, MSTATUS_MIE);
+  moncontrol(1);
+}
+
+void
+moncontrol(int mode)
+{
+  gmon_on = mode && gmon_hist != NULL;
+}
+
+static void
+gmon_dump(void)
+{
+  console_puts("\n--- gmon.out ");
+  console_putu(__gmon_image_size);
+  console_puts(" bytes ---\n");
+  console_hex(__gmon_image, __gmon_image_size);
+  console_puts("--- end gmon.out ---\n");
+}
+
+void
+_mcleanup(void)
+{
+  uint32_t word;
+  char *p;
+
+  if (gmon_hist == NULL || __gmon_image_size != 0)
+    return;
+
+  moncontrol(0);
+  timer_tick(0, NULL);
+
+  p = __gmon_image;
+  memcpy(p, GMON_MAGIC, 4);
+  word = GMON_VERSION;
+  memcpy(p + 4, &word, 4);
+  p += GMON_HDR_SIZE;
+
+  *p++ = GMON_TAG_TIME_HIST;
+  memcpy(p, &gmon_lowpc, sizeof(void *));
+  p += sizeof(void *);
+  memcpy(p, &gmon_highpc, sizeof(void *));
+  p += sizeof(void *);
+  word = gmon_bins;
+  memcpy(p, &word, 4);
+  p += 4;
+  word = gmon_rate;
+  memcpy(p, &word, 4);
+  p += 4;
+  memcpy(p, "seconds", 7);
+  p += 15;
+  *p = 's';
+
+  __gmon_image_size = GMON_HEADERS + gmon_bins * sizeof(uint16_t);
+
+  if (gmon_console)
+    gmon_dump();
+}
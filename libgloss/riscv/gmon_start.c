@@ -0,0 +1,33 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * Whole-program profiling for -p and -pg. The specs files pass
+ * -u __gmon_start when linking with either option, which pulls in this
+ * constructor; it starts sampling the text segment before main and
+ * produces gmon.out at exit. See <machine/gmon.h>.
+ */
+
+#include <stdlib.h>
+#include <machine/gmon.h>
+
+/* Bounds of the text segment, defined by the linker script */
+extern char __text_start[];
+extern char _etext[];
+
+void __gmon_start(void) __attribute__((constructor));
+
+void
+__gmon_start(void)
+{
+  monstartup((unsigned long)__text_start, (unsigned long)_etext);
+  atexit(_mcleanup);
+}
+
+/**
+ * Code compiled with -pg calls _mcount on function entry. Only the pc
+ * samples are used, so the call itself records nothing.
+ */
+__attribute__((weak)) void
+_mcount(void)
+{
+}
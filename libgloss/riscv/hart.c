@@ -0,0 +1,119 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * Secondary hart release, see <machine/hart.h>.
+ *
+ * A parked hart waits in WFI with only its software interrupt enabled.
+ * hart_start() fills the mailbox of the target hart and raises its MSIP
+ * bit in the CLINT. Interrupts stay globally disabled on parked harts,
+ * so the wakeup does not trap; the hart notices the pending MSIP, clears
+ * it and runs the function from its mailbox. Memory is only read after
+ * such a wakeup, which cannot happen before hart 0 has cleared .bss.
+ */
+
+#include <errno.h>
+#include <machine/hart.h>
+#include "clint.h"
+#include "encoding.h"
+
+/* Number of harts, defined by the linker script */
+extern char __hart_count[];
+
+struct hart_mailbox
+{
+  void (*volatile fn)(void *);
+  void *volatile arg;
+  volatile int busy;
+};
+
+#ifndef HART_MAX
+#define HART_MAX	8
+#endif
+
+static struct hart_mailbox hart_mailbox[HART_MAX];
+
+unsigned long
+hart_count(void)
+{
+  unsigned long count = (unsigned long)__hart_count;
+
+  return count < HART_MAX ? count : HART_MAX;
+}
+
+int
+hart_start(unsigned long hartid, void (*fn)(void *), void *arg)
+{
+  struct hart_mailbox *mb;
+  int expected = 0;
+
+  if (hartid == 0 || hartid >= hart_count() || fn == NULL)
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  mb = &hart_mailbox[hartid];
+
+  /* Claim the mailbox, several harts may start the same target */
+#ifdef __riscv_atomic
+  if (!__atomic_compare_exchange_n(&mb->busy, &expected, 1, 0,
+                                   __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+  {
+    errno = EBUSY;
+    return -1;
+  }
+#else
+  if (mb->busy != expected)
+  {
+    errno = EBUSY;
+    return -1;
+  }
+  mb->busy = 1;
+#endif
+
+  mb->arg = arg;
+  mb->fn = fn;
+
+  /* Make the mailbox visible before the wakeup */
+  __asm__ volatile ("fence w, o" ::: "memory");
+  CLINT_MSIP(hartid) = 1;
+
+  return 0;
+}
+
+int
+hart_busy(unsigned long hartid)
+{
+  return hartid < HART_MAX && hart_mailbox[hartid].busy;
+}
+
+/* Entered from crt0 by every hart except hart 0, never returns */
+void
+__hart_park(unsigned long hartid)
+{
+  struct hart_mailbox *mb = &hart_mailbox[hartid];
+  void (*fn)(void *);
+
+  /* More harts than mailboxes, this one is never used */
+  while (hartid >= HART_MAX) __asm__ volatile ("wfi");
+
+  write_csr(mie, MIP_MSIP);
+
+  while (1)
+  {
+    __asm__ volatile ("wfi");
+    if ((read_csr(mip) & MIP_MSIP) == 0) continue;
+
+    CLINT_MSIP(hartid) = 0;
+    __asm__ volatile ("fence i, r" ::: "memory");
+
+    fn = mb->fn;
+    if (fn == NULL) continue;
+    mb->fn = NULL;
+
+    fn(mb->arg);
+
+    __asm__ volatile ("fence rw, w" ::: "memory");
+    mb->busy = 0;
+  }
+}
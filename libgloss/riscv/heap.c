@@ -0,0 +1,224 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * Heap regions, see <machine/heap.h>.
+ *
+ * Every region is an address range from the linker script with its own
+ * break. _sbrk_r moves the break of HEAP_DRAM for malloc. The other
+ * regions are carved by malloc_region: blocks carry their size in a
+ * 16-byte header, and free blocks are kept in a list sorted by address,
+ * allocated first fit and merged with their neighbours when released.
+ * When no free block fits, the region's break grows, taking in a free
+ * block that ends at the break. One spinlock covers all regions but
+ * HEAP_DRAM, which newlib's malloc lock already serializes.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <reent.h>
+#include <machine/heap.h>
+#include "encoding.h"
+
+#define HEAP_ALIGN		16
+#define HEAP_HEADER		16	/* Keeps the payload aligned */
+#define HEAP_MIN		(HEAP_HEADER + HEAP_ALIGN)
+
+extern char _heap_start[];
+extern char _heap_end[];
+
+/* Weak, so that linker scripts without a fast region leave it empty */
+extern char _sram_heap_start[] __attribute__((weak));
+extern char _sram_heap_end[] __attribute__((weak));
+
+struct heap_block
+{
+  size_t size;			/* Including the header */
+  struct heap_block *next;	/* Next free block, if free */
+};
+
+struct heap_region
+{
+  char *start;
+  char *end;
+  char *brk;			/* NULL until first use */
+  struct heap_block *free;
+};
+
+static struct heap_region heap_regions[HEAP_REGIONS] = {
+  [HEAP_DRAM]		= { _heap_start, _heap_end, NULL, NULL },
+  [HEAP_FAST_SRAM]	= { _sram_heap_start, _sram_heap_end, NULL, NULL },
+};
+
+static int heap_lock_word;
+
+static char *
+region_brk(struct heap_region *r)
+{
+  if (r->brk == NULL)
+  {
+    r->brk = (char *)(((uintptr_t)r->start + HEAP_ALIGN - 1)
+                      & ~(uintptr_t)(HEAP_ALIGN - 1));
+    if (r->brk > r->end)
+      r->brk = r->end;
+  }
+  return r->brk;
+}
+
+void *
+_sbrk_r(struct _reent *reent, ptrdiff_t incr)
+{
+  struct heap_region *r = &heap_regions[HEAP_DRAM];
+  char *prev = r->brk ? r->brk : r->start;
+  char *next;
+
+  // Always return data aligned on a 8 byte boundary
+  next = (char *)(((uintptr_t)prev + incr + 7) & ~(uintptr_t)7);
+  if (next < r->start || next >= r->end)
+  {
+    __errno_r(reent) = ENOMEM;
+    return (void *)-1;
+  }
+
+  r->brk = next;
+  return prev;
+}
+
+/* Unlink and return a free block of at least size bytes, or grow */
+static struct heap_block *
+region_take(struct heap_region *r, size_t size)
+{
+  struct heap_block **link, **last = NULL;
+  struct heap_block *b, *rest;
+  char *brk = region_brk(r);
+  size_t grow;
+
+  for (link = &r->free; (b = *link) != NULL; link = &b->next)
+  {
+    if (b->size >= size)
+    {
+      if (b->size - size >= HEAP_MIN)
+      {
+        rest = (struct heap_block *)((char *)b + size);
+        rest->size = b->size - size;
+        rest->next = b->next;
+        *link = rest;
+        b->size = size;
+      }
+      else
+        *link = b->next;
+      return b;
+    }
+    last = link;
+  }
+
+  /* Grow the block at the break, if free, or start a new one */
+  b = NULL;
+  grow = size;
+  if (last && (char *)*last + (*last)->size == brk)
+  {
+    b = *last;
+    grow = size - b->size;
+  }
+  if (grow > (size_t)(r->end - brk))
+    return NULL;
+
+  if (b)
+    *last = NULL;
+  else
+    b = (struct heap_block *)brk;
+  b->size = size;
+  r->brk = brk + grow;
+  return b;
+}
+
+void *
+malloc_region(int region, size_t size)
+{
+  struct heap_block *b;
+  size_t need;
+
+  if (region <= HEAP_DRAM || region >= HEAP_REGIONS
+      || size > PTRDIFF_MAX - HEAP_MIN)
+    return malloc(size);
+
+  need = (size + HEAP_HEADER + HEAP_ALIGN - 1) & ~(size_t)(HEAP_ALIGN - 1);
+
+  spin_lock(&heap_lock_word);
+  b = region_take(&heap_regions[region], need);
+  spin_unlock(&heap_lock_word);
+
+  if (b == NULL)
+    return malloc(size);
+  return (char *)b + HEAP_HEADER;
+}
+
+void
+free_region(void *ptr)
+{
+  struct heap_region *r;
+  struct heap_block **link, *b, *prev = NULL;
+  int region = heap_region_of(ptr);
+
+  if (region <= HEAP_DRAM)
+  {
+    free(ptr);
+    return;
+  }
+
+  r = &heap_regions[region];
+  b = (struct heap_block *)((char *)ptr - HEAP_HEADER);
+
+  spin_lock(&heap_lock_word);
+  for (link = &r->free; *link != NULL && *link < b; link = &(*link)->next)
+    prev = *link;
+
+  b->next = *link;
+  *link = b;
+  if (b->next && (char *)b + b->size == (char *)b->next)
+  {
+    b->size += b->next->size;
+    b->next = b->next->next;
+  }
+  if (prev && (char *)prev + prev->size == (char *)b)
+  {
+    prev->size += b->size;
+    prev->next = b->next;
+  }
+  spin_unlock(&heap_lock_word);
+}
+
+int
+heap_region_of(const void *ptr)
+{
+  const char *p = ptr;
+  int region;
+
+  for (region = 0; region < HEAP_REGIONS; region++)
+    if (p >= heap_regions[region].start && p < heap_regions[region].end)
+      return region;
+  return -1;
+}
+
+size_t
+heap_region_avail(int region)
+{
+  struct heap_region *r;
+  struct heap_block *b;
+  size_t avail;
+
+  if (region < 0 || region >= HEAP_REGIONS)
+    return 0;
+
+  r = &heap_regions[region];
+  if (region == HEAP_DRAM)
+    return r->end - (r->brk ? r->brk : r->start);
+
+  spin_lock(&heap_lock_word);
+  avail = r->end - region_brk(r);
+  for (b = r->free; b != NULL; b = b->next)
+    avail += b->size;
+  spin_unlock(&heap_lock_word);
+  return avail;
+}
@@ -0,0 +1,672 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * Host I/O, see hostio.h and <machine/hostio.h>.
+ *
+ * Built once with USING_SEMIHOSTING and once with USING_HTIF. Each
+ * backend provides the host_* primitives, which return a negative errno
+ * value on failure; the hostio_* functions on top keep the descriptor
+ * table and convert the errors for the caller's _reent.
+ *
+ * Semihosting has no notion of a current position, so the offset of
+ * every file is kept here for SEEK_CUR. The HTIF proxy forwards the
+ * calls to the host's own file descriptors, which keep their offsets.
+ * One spinlock serializes the HTIF channel and the descriptor table.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <machine/syscall.h>
+#include "encoding.h"
+#include "hostio.h"
+
+#if defined(USING_SEMIHOSTING) && defined(USING_HTIF)
+#error "USING_SEMIHOSTING and USING_HTIF are exclusive"
+#endif
+#ifndef USING_HOSTIO
+#error "hostio.c needs USING_SEMIHOSTING or USING_HTIF"
+#endif
+
+struct hostio_fd
+{
+  int open;
+  int tty;
+  long host;			/* Descriptor on the host */
+  _off_t offset;		/* Semihosting only */
+};
+
+static struct hostio_fd hostio_fds[HOSTIO_FDS];
+
+static int hostio_lock_word;
+
+#ifdef USING_SEMIHOSTING
+
+/**
+ * The semihosting trap is an ebreak between two hint instructions, which
+ * the host recognizes only as uncompressed instructions in one page.
+ * a0 holds the operation, a1 the address of its parameter block.
+ */
+__asm__ (
+  "	.pushsection .text.__semihost_call, \"ax\", @progbits\n"
+  "	.balign 16\n"
+  "	.option push\n"
+  "	.option norvc\n"
+  "	.type __semihost_call, @function\n"
+  "__semihost_call:\n"
+  "	slli zero, zero, 0x1f\n"
+  "	ebreak\n"
+  "	srai zero, zero, 7\n"
+  "	ret\n"
+  "	.size __semihost_call, . - __semihost_call\n"
+  "	.option pop\n"
+  "	.popsection\n");
+
+long __semihost_call(long op, const void *args)
+  __attribute__((visibility("hidden")));
+
+#define ADP_Stopped_ApplicationExit	0x20026
+
+static long
+sh_error(void)
+{
+  long err = __semihost_call(SEMIHOST_errno, NULL);
+
+  return err > 0 ? -err : -EIO;
+}
+
+/* Index into "r", "rb", "r+", "r+b", "w", "wb", "w+", "w+b", "a", ... */
+static long
+sh_mode(int flags)
+{
+  long rw = (flags & O_ACCMODE) == O_RDWR ? 2 : 0;
+
+  if (flags & O_APPEND)
+    return 9 + rw;
+  if ((flags & O_ACCMODE) == O_RDONLY)
+    return 1;
+  if (flags & O_TRUNC)
+    return 5 + rw;
+  return 3;
+}
+
+static long
+sh_open(const char *path, long mode)
+{
+  long args[3] = { (long)path, mode, (long)strlen(path) };
+  long h = __semihost_call(SEMIHOST_open, args);
+
+  return h < 0 ? sh_error() : h;
+}
+
+static long
+host_open(const char *path, int flags, int mode)
+{
+  long args[1];
+  long h;
+
+  if ((flags & O_CREAT) && (flags & O_EXCL))
+  {
+    if ((h = sh_open(path, 1)) >= 0)
+    {
+      args[0] = h;
+      __semihost_call(SEMIHOST_close, args);
+      return -EEXIST;
+    }
+  }
+
+  /* "r+b" keeps the contents but does not create a missing file */
+  h = sh_open(path, sh_mode(flags));
+  if (h == -ENOENT && (flags & O_CREAT) && sh_mode(flags) == 3)
+    h = sh_open(path, (flags & O_ACCMODE) == O_RDWR ? 7 : 5);
+  return h;
+}
+
+static void
+host_console(struct hostio_fd *d, int fd)
+{
+  /* ":tt" opened for reading is stdin, for writing stdout, for append stderr */
+  static const long mode[3] = { 0, 4, 8 };
+  long h = sh_open(":tt", mode[fd]);
+
+  if (h >= 0)
+  {
+    d->host = h;
+    d->tty = 1;
+    d->open = 1;
+  }
+}
+
+static long
+host_close(struct hostio_fd *d)
+{
+  long args[1] = { d->host };
+
+  return __semihost_call(SEMIHOST_close, args) < 0 ? sh_error() : 0;
+}
+
+/* Semihosting returns the number of bytes not transferred */
+static long
+host_read(struct hostio_fd *d, void *buf, size_t len)
+{
+  long args[3] = { d->host, (long)buf, (long)len };
+  long left = __semihost_call(SEMIHOST_read, args);
+
+  if (left < 0 || (size_t)left > len)
+    return sh_error();
+  d->offset += len - left;
+  return len - left;
+}
+
+static long
+host_write(struct hostio_fd *d, const void *buf, size_t len)
+{
+  long args[3] = { d->host, (long)buf, (long)len };
+  long left = __semihost_call(SEMIHOST_write, args);
+
+  if (left < 0 || (size_t)left > len)
+    return sh_error();
+  d->offset += len - left;
+  return len - left;
+}
+
+static long
+sh_flen(long h)
+{
+  long args[1] = { h };
+  long size = __semihost_call(SEMIHOST_flen, args);
+
+  return size < 0 ? sh_error() : size;
+}
+
+static _off_t
+host_lseek(struct hostio_fd *d, _off_t offset, int whence)
+{
+  long args[2];
+  long base;
+
+  switch (whence)
+  {
+    case SEEK_SET:
+      base = 0;
+      break;
+    case SEEK_CUR:
+      base = d->offset;
+      break;
+    case SEEK_END:
+      if ((base = sh_flen(d->host)) < 0)
+        return base;
+      break;
+    default:
+      return -EINVAL;
+  }
+  if (base + offset < 0)
+    return -EINVAL;
+
+  args[0] = d->host;
+  args[1] = base + offset;
+  if (__semihost_call(SEMIHOST_seek, args) < 0)
+    return sh_error();
+  d->offset = base + offset;
+  return d->offset;
+}
+
+static long
+host_fstat(struct hostio_fd *d, struct stat *st)
+{
+  long size;
+
+  memset(st, 0, sizeof(*st));
+  st->st_nlink = 1;
+  if (d->tty)
+  {
+    st->st_mode = S_IFCHR;
+    return 0;
+  }
+
+  if ((size = sh_flen(d->host)) < 0)
+    return size;
+  st->st_mode = S_IFREG | 0644;
+  st->st_size = size;
+  st->st_blksize = HOSTIO_BUFSIZE;
+  st->st_blocks = (size + 511) / 512;
+  return 0;
+}
+
+static long
+host_stat(const char *path, struct stat *st)
+{
+  struct hostio_fd d = { 1, 0, 0, 0 };
+  long ret;
+
+  if ((d.host = sh_open(path, 1)) < 0)
+    return d.host;
+  ret = host_fstat(&d, st);
+  host_close(&d);
+  return ret;
+}
+
+static long
+host_unlink(const char *path)
+{
+  long args[2] = { (long)path, (long)strlen(path) };
+
+  return __semihost_call(SEMIHOST_remove, args) != 0 ? sh_error() : 0;
+}
+
+static long
+host_rename(const char *old, const char *new)
+{
+  long args[4] = { (long)old, (long)strlen(old), (long)new, (long)strlen(new) };
+
+  return __semihost_call(SEMIHOST_rename, args) != 0 ? sh_error() : 0;
+}
+
+void
+hostio_exit(int status)
+{
+  long args[2] = { ADP_Stopped_ApplicationExit, status };
+
+  /* SYS_EXIT takes the block on RV64, but only the reason on RV32 */
+#if __riscv_xlen == 64
+  __semihost_call(SEMIHOST_exit, args);
+#else
+  __semihost_call(SEMIHOST_exit_extended, args);
+#endif
+  while (1);
+}
+
+#else /* USING_HTIF */
+
+#include "htif.h"
+#include "kernel_stat.h"
+
+#define HTIF_AT_FDCWD		-100
+
+/* Linux open flags, which the proxy passes to the host unchanged */
+#define HTIF_O_CREAT		0100
+#define HTIF_O_EXCL		0200
+#define HTIF_O_TRUNC		01000
+#define HTIF_O_APPEND		02000
+
+static volatile uint64_t htif_mem[8] __attribute__((aligned(64)));
+
+/* Device 0, command 0: a system call described by htif_mem */
+static long
+htif_syscall(long n, long a0, long a1, long a2, long a3, long a4, long a5)
+{
+  long ret;
+
+  spin_lock(&hostio_lock_word);
+  htif_mem[0] = n;
+  htif_mem[1] = a0;
+  htif_mem[2] = a1;
+  htif_mem[3] = a2;
+  htif_mem[4] = a3;
+  htif_mem[5] = a4;
+  htif_mem[6] = a5;
+  __asm__ volatile ("fence" ::: "memory");
+
+  htif_tohost((uintptr_t)htif_mem);
+  while (fromhost == 0);
+  fromhost = 0;
+
+  __asm__ volatile ("fence" ::: "memory");
+  ret = htif_mem[0];
+  spin_unlock(&hostio_lock_word);
+  return ret;
+}
+
+static long
+host_open(const char *path, int flags, int mode)
+{
+  long f = flags & O_ACCMODE;
+
+  if (flags & O_CREAT)
+    f |= HTIF_O_CREAT;
+  if (flags & O_EXCL)
+    f |= HTIF_O_EXCL;
+  if (flags & O_TRUNC)
+    f |= HTIF_O_TRUNC;
+  if (flags & O_APPEND)
+    f |= HTIF_O_APPEND;
+
+  /* The proxy copies the path out of target memory, so it needs the length */
+  return htif_syscall(SYS_openat, HTIF_AT_FDCWD, (long)path, strlen(path) + 1,
+                      f, mode, 0);
+}
+
+static void
+host_console(struct hostio_fd *d, int fd)
+{
+  d->host = fd;
+  d->tty = 1;
+  d->open = 1;
+}
+
+static long
+host_close(struct hostio_fd *d)
+{
+  return htif_syscall(SYS_close, d->host, 0, 0, 0, 0, 0);
+}
+
+static long
+host_read(struct hostio_fd *d, void *buf, size_t len)
+{
+  return htif_syscall(SYS_read, d->host, (long)buf, len, 0, 0, 0);
+}
+
+static long
+host_write(struct hostio_fd *d, const void *buf, size_t len)
+{
+  return htif_syscall(SYS_write, d->host, (long)buf, len, 0, 0, 0);
+}
+
+static _off_t
+host_lseek(struct hostio_fd *d, _off_t offset, int whence)
+{
+  return htif_syscall(SYS_lseek, d->host, offset, whence, 0, 0, 0);
+}
+
+void
+_conv_stat(struct stat *st, struct kernel_stat *k)
+{
+  memset(st, 0, sizeof(*st));
+  st->st_dev = k->st_dev;
+  st->st_ino = k->st_ino;
+  st->st_mode = k->st_mode;
+  st->st_nlink = k->st_nlink;
+  st->st_uid = k->st_uid;
+  st->st_gid = k->st_gid;
+  st->st_rdev = k->st_rdev;
+  st->st_size = k->st_size;
+  st->st_blksize = k->st_blksize;
+  st->st_blocks = k->st_blocks;
+  st->st_atim = k->st_atim;
+  st->st_mtim = k->st_mtim;
+  st->st_ctim = k->st_ctim;
+}
+
+static void
+htif_stat(struct stat *st, struct kernel_stat *k)
+{
+  _conv_stat(st, k);
+  if (S_ISREG(st->st_mode))
+    st->st_blksize = HOSTIO_BUFSIZE;
+}
+
+static long
+host_fstat(struct hostio_fd *d, struct stat *st)
+{
+  struct kernel_stat k;
+  long ret;
+
+  if ((ret = htif_syscall(SYS_fstat, d->host, (long)&k, 0, 0, 0, 0)) < 0)
+    return ret;
+  htif_stat(st, &k);
+  return 0;
+}
+
+static long
+host_stat(const char *path, struct stat *st)
+{
+  struct kernel_stat k;
+  long ret;
+
+  ret = htif_syscall(SYS_fstatat, HTIF_AT_FDCWD, (long)path, strlen(path) + 1,
+                     (long)&k, 0, 0);
+  if (ret < 0)
+    return ret;
+  htif_stat(st, &k);
+  return 0;
+}
+
+static long
+host_unlink(const char *path)
+{
+  return htif_syscall(SYS_unlinkat, HTIF_AT_FDCWD, (long)path, strlen(path) + 1,
+                      0, 0, 0);
+}
+
+static long
+host_rename(const char *old, const char *new)
+{
+  return htif_syscall(SYS_renameat, HTIF_AT_FDCWD, (long)old, strlen(old) + 1,
+                      HTIF_AT_FDCWD, (long)new, strlen(new) + 1);
+}
+
+void
+hostio_exit(int status)
+{
+  htif_tohost(((uint64_t)(unsigned int)status << 1) | 1);
+  while (1);
+}
+
+#endif /* USING_HTIF */
+
+/* Set errno from a host_* result, which is returned unless it is an error */
+static long
+host_result(struct _reent *reent, long ret)
+{
+  if (ret < 0)
+  {
+    __errno_r(reent) = -ret;
+    return -1;
+  }
+  return ret;
+}
+
+/* The console descriptors are opened on first use */
+static struct hostio_fd *
+fd_lookup(int fd)
+{
+  struct hostio_fd *d;
+
+  if (fd < 0 || fd >= HOSTIO_FDS)
+    return NULL;
+
+  d = &hostio_fds[fd];
+  if (!d->open && fd < 3)
+  {
+    spin_lock(&hostio_lock_word);
+    if (!d->open)
+      host_console(d, fd);
+    spin_unlock(&hostio_lock_word);
+  }
+  return d->open ? d : NULL;
+}
+
+int
+hostio_open(struct _reent *reent, const char *path, int flags, int mode)
+{
+  long h;
+  int fd;
+
+  if ((h = host_open(path, flags, mode)) < 0)
+    return host_result(reent, h);
+
+  spin_lock(&hostio_lock_word);
+  for (fd = 3; fd < HOSTIO_FDS; fd++)
+  {
+    if (!hostio_fds[fd].open)
+    {
+      hostio_fds[fd].open = 1;
+      hostio_fds[fd].tty = 0;
+      hostio_fds[fd].host = h;
+      hostio_fds[fd].offset = 0;
+      break;
+    }
+  }
+  spin_unlock(&hostio_lock_word);
+
+  if (fd == HOSTIO_FDS)
+  {
+    struct hostio_fd d = { 1, 0, h, 0 };
+
+    host_close(&d);
+    __errno_r(reent) = EMFILE;
+    return -1;
+  }
+  return fd;
+}
+
+int
+hostio_close(struct _reent *reent, int fd)
+{
+  struct hostio_fd *d;
+  long ret;
+
+  if ((d = fd_lookup(fd)) == NULL)
+  {
+    __errno_r(reent) = EBADF;
+    return -1;
+  }
+
+  /* The console stays open */
+  if (fd < 3)
+    return 0;
+
+  ret = host_close(d);
+  __atomic_store_n(&d->open, 0, __ATOMIC_RELEASE);
+  return host_result(reent, ret);
+}
+
+_ssize_t
+hostio_read(struct _reent *reent, int fd, void *buf, size_t len)
+{
+  struct hostio_fd *d;
+
+  if ((d = fd_lookup(fd)) == NULL)
+  {
+    __errno_r(reent) = EBADF;
+    return -1;
+  }
+  return host_result(reent, host_read(d, buf, len));
+}
+
+_ssize_t
+hostio_write(struct _reent *reent, int fd, const void *buf, size_t len)
+{
+  struct hostio_fd *d;
+
+  if ((d = fd_lookup(fd)) == NULL)
+  {
+    __errno_r(reent) = EBADF;
+    return -1;
+  }
+  return host_result(reent, host_write(d, buf, len));
+}
+
+_off_t
+hostio_lseek(struct _reent *reent, int fd, _off_t offset, int whence)
+{
+  struct hostio_fd *d;
+
+  if ((d = fd_lookup(fd)) == NULL)
+  {
+    __errno_r(reent) = EBADF;
+    return -1;
+  }
+  if (d->tty)
+  {
+    __errno_r(reent) = ESPIPE;
+    return -1;
+  }
+  return host_result(reent, host_lseek(d, offset, whence));
+}
+
+int
+hostio_fstat(struct _reent *reent, int fd, struct stat *st)
+{
+  struct hostio_fd *d;
+
+  if ((d = fd_lookup(fd)) == NULL)
+  {
+    __errno_r(reent) = EBADF;
+    return -1;
+  }
+  return host_result(reent, host_fstat(d, st));
+}
+
+int
+hostio_stat(struct _reent *reent, const char *path, struct stat *st)
+{
+  return host_result(reent, host_stat(path, st));
+}
+
+int
+hostio_isatty(struct _reent *reent, int fd)
+{
+  struct hostio_fd *d;
+
+  if ((d = fd_lookup(fd)) == NULL)
+  {
+    __errno_r(reent) = EBADF;
+    return 0;
+  }
+  if (!d->tty)
+    __errno_r(reent) = ENOTTY;
+  return d->tty;
+}
+
+int
+hostio_unlink(struct _reent *reent, const char *path)
+{
+  return host_result(reent, host_unlink(path));
+}
+
+int
+hostio_rename(struct _reent *reent, const char *old, const char *new)
+{
+  return host_result(reent, host_rename(old, new));
+}
+
+ssize_t
+hostio_load(const char *path, void *buf, size_t size)
+{
+  struct hostio_fd d = { 1, 0, 0, 0 };
+  long ret;
+
+  if ((d.host = host_open(path, O_RDONLY, 0)) < 0)
+    return host_result(_REENT, d.host);
+
+  ret = host_read(&d, buf, size);
+  host_close(&d);
+  return host_result(_REENT, ret);
+}
+
+void *
+hostio_load_alloc(const char *path, size_t *size)
+{
+  struct hostio_fd d = { 1, 0, 0, 0 };
+  struct stat st;
+  void *buf = NULL;
+  long ret;
+
+  if ((d.host = host_open(path, O_RDONLY, 0)) < 0)
+  {
+    host_result(_REENT, d.host);
+    return NULL;
+  }
+
+  if ((ret = host_fstat(&d, &st)) == 0)
+  {
+    /* One spare byte, so that an empty file still gets a buffer */
+    if ((buf = malloc(st.st_size + 1)) == NULL)
+      ret = -ENOMEM;
+    else if ((ret = host_read(&d, buf, st.st_size)) >= 0)
+      *size = ret;
+  }
+  host_close(&d);
+
+  if (ret < 0)
+  {
+    free(buf);
+    host_result(_REENT, ret);
+    return NULL;
+  }
+  return buf;
+}
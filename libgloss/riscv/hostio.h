@@ -0,0 +1,53 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * File and console I/O forwarded to the host, for the libsemihost and
+ * libhtif variants of libgloss (semihost.specs, htif.specs).
+ *
+ * Descriptors 0-2 are the host's console, the others are host files
+ * opened by path. ROM files keep their own descriptors above
+ * HOSTIO_FDS. The functions follow the _*_r conventions of syscalls.c.
+ */
+
+#ifndef _RISCV_HOSTIO_H
+#define _RISCV_HOSTIO_H
+
+#include <reent.h>
+#include <sys/stat.h>
+#include <machine/hostio.h>
+#include "romfs.h"
+
+#if defined(USING_SEMIHOSTING) || defined(USING_HTIF)
+#define USING_HOSTIO
+#endif
+
+/* Open descriptors, including the three console ones */
+#ifndef HOSTIO_FDS
+#define HOSTIO_FDS			16
+#endif
+
+/* st_blksize, and so the stdio buffer size, of host files */
+#ifndef HOSTIO_BUFSIZE
+#define HOSTIO_BUFSIZE		65536
+#endif
+
+#if HOSTIO_FDS > ROMFS_FD_FIRST
+#error "HOSTIO_FDS overlaps the ROM file descriptors"
+#endif
+
+int hostio_open(struct _reent *reent, const char *path, int flags, int mode);
+int hostio_close(struct _reent *reent, int fd);
+_ssize_t hostio_read(struct _reent *reent, int fd, void *buf, size_t len);
+_ssize_t hostio_write(struct _reent *reent, int fd, const void *buf,
+                      size_t len);
+_off_t hostio_lseek(struct _reent *reent, int fd, _off_t offset, int whence);
+int hostio_fstat(struct _reent *reent, int fd, struct stat *st);
+int hostio_stat(struct _reent *reent, const char *path, struct stat *st);
+int hostio_isatty(struct _reent *reent, int fd);
+int hostio_unlink(struct _reent *reent, const char *path);
+int hostio_rename(struct _reent *reent, const char *old, const char *new);
+
+/* End the simulation with status, does not return */
+void hostio_exit(int status) __attribute__((noreturn));
+
+#endif /* _RISCV_HOSTIO_H */
@@ -0,0 +1,22 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * HTIF mailbox words, see htif.h.
+ */
+
+#include "htif.h"
+
+volatile uint64_t tohost __attribute__((section(".htif"), aligned(64)));
+volatile uint64_t fromhost __attribute__((section(".htif"), aligned(64)));
+
+void
+htif_tohost(uint64_t value)
+{
+#if __riscv_xlen == 32
+  /* The host acts on the low word, so it must arrive last */
+  ((volatile uint32_t *)&tohost)[1] = value >> 32;
+  ((volatile uint32_t *)&tohost)[0] = value;
+#else
+  tohost = value;
+#endif
+}
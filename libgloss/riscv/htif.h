@@ -0,0 +1,24 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * Host-target interface of Spike and other fesvr-based simulators.
+ *
+ * The simulator finds tohost and fromhost by name in the ELF file. A
+ * target request is a command word written to tohost; the host answers
+ * through fromhost, which the target clears again. Bit 0 of a command to
+ * device 0 ends the simulation with the status in the bits above,
+ * otherwise device 0 takes the address of a system call block.
+ */
+
+#ifndef _RISCV_HTIF_H
+#define _RISCV_HTIF_H
+
+#include <stdint.h>
+
+extern volatile uint64_t tohost;
+extern volatile uint64_t fromhost;
+
+/* Write a command word to tohost */
+void htif_tohost(uint64_t value);
+
+#endif /* _RISCV_HTIF_H */
@@ -0,0 +1,110 @@
+/* Copyright (C) SoCHub Finland 2024
+
+   This copyrighted material is made available to anyone wishing to use,
+   modify, copy, or redistribute it subject to the terms and conditions
+   of the FreeBSD License.   This program is distributed in the hope that
+   it will be useful, but WITHOUT ANY WARRANTY expressed or implied,
+   including the implied warranties of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  A copy of this license is available at
+   http://www.opensource.org/licenses.
+*/
+
+/* Deferred-formatting logging.
+
+   binlog (fmt, ...) takes printf arguments but formats nothing on the
+   target.  The format string is placed in the binlog_fmt section and the
+   call sends only its offset in that section and the raw argument
+   values to the console UART.  The host-side decoder
+   (libgloss/riscv/tools/binlog_decode.py) reads the ELF file to rebuild
+   the text.
+
+   Each record is framed as
+
+     BINLOG_SYNC, payload length, ULEB128 (format id), ULEB128 (arg)...
+
+   where the format id is the offset of the string in binlog_fmt plus
+   one, and every argument is sign-extended to 64 bits and zigzag-encoded,
+   floating-point arguments by their IEEE double bit pattern.  Id 0 is the
+   header sent at startup, whose only argument is the size of binlog_fmt.
+   Ordinary console output can be freely mixed with records.
+
+   At most BINLOG_MAX_ARGS arguments are supported.  %s arguments must
+   point to strings stored in the ELF file, such as string literals.
+   The macro relies on _Generic and is only available from C.  */
+
+#ifndef _MACHINE_BINLOG_H
+#define _MACHINE_BINLOG_H
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BINLOG_SYNC		0x1e
+#define BINLOG_MAX_ARGS		8
+
+void __binlog_emit (const char *__fmt, unsigned int __nargs,
+		    const int64_t *__args);
+
+/* Send the startup header record, called from crt0.  */
+void binlog_init (void);
+
+static inline int64_t
+__binlog_double (double __d)
+{
+  int64_t __v;
+
+  memcpy (&__v, &__d, sizeof (__v));
+  return __v;
+}
+
+/* Widen one argument to 64 bits according to its C type.  */
+#define __BINLOG_AS(x, T, alt) __extension__ _Generic ((x), T: (x), default: (alt))
+#define __BINLOG_WORD(x) __extension__ _Generic ((x),			\
+  float: __binlog_double (__BINLOG_AS (x, float, 0.0)),			\
+  double: __binlog_double (__BINLOG_AS (x, double, 0.0)),		\
+  long long: (int64_t) __BINLOG_AS (x, long long, 0),			\
+  unsigned long long: (int64_t) __BINLOG_AS (x, unsigned long long, 0),	\
+  default: (int64_t) (intptr_t) __extension__ _Generic ((x),		\
+    float: 0, double: 0, long long: 0, unsigned long long: 0,		\
+    default: (x)))
+
+/* Count and map the arguments following the format string.  */
+#define __BINLOG_NARGS(...) \
+  __BINLOG_NARGS_ (__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define __BINLOG_NARGS_(f, _1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+
+#define __BINLOG_CAT(a, b) __BINLOG_CAT_ (a, b)
+#define __BINLOG_CAT_(a, b) a##b
+
+#define __BINLOG_MAP0(f)
+#define __BINLOG_MAP1(f, a) __BINLOG_WORD (a)
+#define __BINLOG_MAP2(f, a, ...) __BINLOG_WORD (a), __BINLOG_MAP1 (f, __VA_ARGS__)
+#define __BINLOG_MAP3(f, a, ...) __BINLOG_WORD (a), __BINLOG_MAP2 (f, __VA_ARGS__)
+#define __BINLOG_MAP4(f, a, ...) __BINLOG_WORD (a), __BINLOG_MAP3 (f, __VA_ARGS__)
+#define __BINLOG_MAP5(f, a, ...) __BINLOG_WORD (a), __BINLOG_MAP4 (f, __VA_ARGS__)
+#define __BINLOG_MAP6(f, a, ...) __BINLOG_WORD (a), __BINLOG_MAP5 (f, __VA_ARGS__)
+#define __BINLOG_MAP7(f, a, ...) __BINLOG_WORD (a), __BINLOG_MAP6 (f, __VA_ARGS__)
+#define __BINLOG_MAP8(f, a, ...) __BINLOG_WORD (a), __BINLOG_MAP7 (f, __VA_ARGS__)
+#define __BINLOG_MAP(...) \
+  __BINLOG_CAT (__BINLOG_MAP, __BINLOG_NARGS (__VA_ARGS__)) (__VA_ARGS__)
+
+#define binlog(fmt, ...)						\
+  do									\
+    {									\
+      static const char __binlog_fmt[]					\
+	__attribute__ ((section ("binlog_fmt"), used)) = fmt;		\
+      const int64_t __binlog_args[] =					\
+	{ 0, __BINLOG_MAP (fmt, ##__VA_ARGS__) };			\
+      __binlog_emit (__binlog_fmt, __BINLOG_NARGS (fmt, ##__VA_ARGS__),	\
+		     __binlog_args + 1);				\
+    }									\
+  while (0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MACHINE_BINLOG_H */
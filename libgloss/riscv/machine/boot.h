@@ -0,0 +1,59 @@
+/* Copyright (C) SoCHub Finland 2024
+
+   This copyrighted material is made available to anyone wishing to use,
+   modify, copy, or redistribute it subject to the terms and conditions
+   of the FreeBSD License.   This program is distributed in the hope that
+   it will be useful, but WITHOUT ANY WARRANTY expressed or implied,
+   including the implied warranties of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  A copy of this license is available at
+   http://www.opensource.org/licenses.
+*/
+
+/* Boot phases of crt0.
+
+   crt0 reads the cycle counter of hart 0 at its first instruction and
+   at the end of every boot phase, and leaves the values in boot_cycles:
+
+     BOOT_EARLY  stack, trap vector, .fast_text and TLS set up
+     BOOT_DATA   .data copied from its load address, or decompressed
+     BOOT_BSS    .bss cleared
+     BOOT_INIT   constructors run
+     BOOT_MAIN   console set up, main about to be called
+
+   so boot_cycles[BOOT_BSS] - boot_cycles[BOOT_DATA] is the time taken to
+   clear .bss.  On RV32 the values are the low 32 bits of the counter,
+   which the differences survive.  Time spent before _enter, such as
+   loading the program, is not counted.
+
+   Buffers that need no initial value go in the .noinit section, which
+   crt0 neither loads nor clears:
+
+     static float frame[1 << 20] __attribute__ ((section (".noinit")));  */
+
+#ifndef _MACHINE_BOOT_H
+#define _MACHINE_BOOT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BOOT_ENTER		0
+#define BOOT_EARLY		1
+#define BOOT_DATA		2
+#define BOOT_BSS		3
+#define BOOT_INIT		4
+#define BOOT_MAIN		5
+#define BOOT_STAMPS		6
+
+/* Cycle counter of hart 0 at _enter and at the end of each phase */
+extern unsigned long boot_cycles[BOOT_STAMPS];
+
+/* Print the cycles of every phase to the console:
+     boot early 310 data 5120 bss 2048 init 96 main 880 total 8454  */
+void boot_report (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MACHINE_BOOT_H */
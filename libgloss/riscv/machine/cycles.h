@@ -0,0 +1,87 @@
+/* Copyright (C) SoCHub Finland 2024
+
+   This copyrighted material is made available to anyone wishing to use,
+   modify, copy, or redistribute it subject to the terms and conditions
+   of the FreeBSD License.   This program is distributed in the hope that
+   it will be useful, but WITHOUT ANY WARRANTY expressed or implied,
+   including the implied warranties of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  A copy of this license is available at
+   http://www.opensource.org/licenses.
+*/
+
+/* Inline readers of the RISC-V counters.
+
+   cycles_read () returns the cycle counter of the calling hart,
+   instret_read () its retired instruction count and timebase_read () the
+   real-time counter shared by all harts.  Each is a single CSR read (a
+   short retry loop on RV32), so code can be timed without a syscall:
+
+     uint64_t t0 = cycles_read ();
+     work ();
+     printf ("%llu cycles\n", cycles_read () - t0);
+
+   The counter frequencies are board settings.  libgloss provides weak
+   defaults for timebase_freq and cpu_freq; a board overrides them by
+   defining its own const unsigned long objects.  clock_gettime () uses
+   them to convert CLOCK_MONOTONIC (time) and CLOCK_PROCESS_CPUTIME_ID
+   (cycle) counts to nanoseconds.  */
+
+#ifndef _MACHINE_CYCLES_H
+#define _MACHINE_CYCLES_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Frequency of the time CSR in Hz */
+extern const unsigned long timebase_freq;
+
+/* Frequency of the cycle CSR (the core clock) in Hz */
+extern const unsigned long cpu_freq;
+
+#if __riscv_xlen == 32
+#define __CYCLES_READ64(lo, hi)						\
+  uint32_t __hi, __lo, __hi2;						\
+									\
+  do									\
+    {									\
+      __asm__ volatile ("rd" #hi " %0" : "=r" (__hi));			\
+      __asm__ volatile ("rd" #lo " %0" : "=r" (__lo));			\
+      __asm__ volatile ("rd" #hi " %0" : "=r" (__hi2));			\
+    }									\
+  while (__hi != __hi2);						\
+									\
+  return ((uint64_t) __hi << 32) | __lo
+#else
+#define __CYCLES_READ64(lo, hi)						\
+  uint64_t __v;								\
+									\
+  __asm__ volatile ("rd" #lo " %0" : "=r" (__v));			\
+  return __v
+#endif
+
+static inline uint64_t
+cycles_read (void)
+{
+  __CYCLES_READ64 (cycle, cycleh);
+}
+
+static inline uint64_t
+instret_read (void)
+{
+  __CYCLES_READ64 (instret, instreth);
+}
+
+static inline uint64_t
+timebase_read (void)
+{
+  __CYCLES_READ64 (time, timeh);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MACHINE_CYCLES_H */
@@ -0,0 +1,66 @@
+/* Copyright (C) SoCHub Finland 2024
+
+   This copyrighted material is made available to anyone wishing to use,
+   modify, copy, or redistribute it subject to the terms and conditions
+   of the FreeBSD License.   This program is distributed in the hope that
+   it will be useful, but WITHOUT ANY WARRANTY expressed or implied,
+   including the implied warranties of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  A copy of this license is available at
+   http://www.opensource.org/licenses.
+*/
+
+/* How _exit reports the exit status.
+
+   _exit drains the console and then hands the status to whatever runs
+   the program, so that simulator and hardware runs can be scripted:
+
+     EXIT_LOOP      stop the hart in a loop, the status is lost
+     EXIT_FINISHER  SiFive test finisher at base (0x100000 on QEMU virt):
+                    0x5555 for status 0, (status << 16) | 0x3333 otherwise
+     EXIT_HTIF      tohost of Spike and other fesvr-based simulators
+     EXIT_MAILBOX   Headsail mailbox at base: the status goes into the
+                    first word, then EXIT_MAILBOX_DONE into the second
+
+   libgloss provides a weak exit_config with EXIT_LOOP; a board or a test
+   harness overrides it by defining its own const struct exit_config
+   exit_config.  With counters set, _exit first prints the cycle and
+   retired instruction counts of the hart:
+
+     exit 0 mcycle 18446321 minstret 9120554
+
+   Programs linked with semihost.specs or htif.specs always report the
+   status to that host.  */
+
+#ifndef _MACHINE_EXIT_H
+#define _MACHINE_EXIT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EXIT_LOOP		0
+#define EXIT_FINISHER		1
+#define EXIT_HTIF		2
+#define EXIT_MAILBOX		3
+
+#define EXIT_FINISHER_PASS	0x5555
+#define EXIT_FINISHER_FAIL	0x3333
+
+#define EXIT_MAILBOX_DONE	0x454e4f44	/* "DONE" */
+
+struct exit_config
+{
+  unsigned int method;		/* EXIT_* */
+  uintptr_t base;		/* Device of EXIT_FINISHER and EXIT_MAILBOX */
+  unsigned int counters;	/* Nonzero to print mcycle and minstret */
+};
+
+extern const struct exit_config exit_config;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MACHINE_EXIT_H */
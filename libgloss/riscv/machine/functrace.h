@@ -0,0 +1,90 @@
+/* Copyright (C) SoCHub Finland 2024
+
+   This copyrighted material is made available to anyone wishing to use,
+   modify, copy, or redistribute it subject to the terms and conditions
+   of the FreeBSD License.   This program is distributed in the hope that
+   it will be useful, but WITHOUT ANY WARRANTY expressed or implied,
+   including the implied warranties of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  A copy of this license is available at
+   http://www.opensource.org/licenses.
+*/
+
+/* Function entry/exit tracing.
+
+   Code compiled with -finstrument-functions calls
+   __cyg_profile_func_enter and __cyg_profile_func_exit around every
+   function.  libgloss records each call in a buffer of the calling hart,
+   __functrace[hartid], without locks: one byte stream per hart, each
+   record being
+
+     ULEB128 (zigzag (fn - previous fn) << 1 | exit), ULEB128 (mcycle delta)
+
+   so that a call to a nearby leaf function takes three to four bytes.
+   On RV64 the distance between two consecutive functions must be below
+   2^62 bytes, as the exit bit takes the top bit of the 64-bit value.
+   When a buffer is full, further records are counted in dropped.
+
+   At exit the buffers are written to the console as a hex dump, unless
+   the board sets functrace_console to 0; a debugger can also save
+   __functrace directly.  libgloss/riscv/tools/functrace.py rebuilds the
+   calls and produces folded stacks for flame graphs and per-function
+   latency histograms.  */
+
+#ifndef _MACHINE_FUNCTRACE_H
+#define _MACHINE_FUNCTRACE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bytes of trace per hart */
+#ifndef FUNCTRACE_SIZE
+#define FUNCTRACE_SIZE		16384
+#endif
+
+/* Harts with a buffer, higher hart ids are not traced */
+#ifndef FUNCTRACE_HARTS
+#define FUNCTRACE_HARTS		4
+#endif
+
+#define FUNCTRACE_MAGIC		0x43525446	/* "FTRC" */
+
+struct functrace
+{
+  uint32_t magic;
+  uint32_t size;		/* Capacity of data */
+  uint32_t used;		/* Bytes of data written */
+  uint32_t dropped;		/* Records lost because data was full */
+  uint64_t start;		/* mcycle the first delta is relative to */
+  uint64_t last_cycle;
+  uintptr_t last_fn;
+  uint8_t data[FUNCTRACE_SIZE];
+};
+
+extern struct functrace __functrace[FUNCTRACE_HARTS];
+
+/* Whether the buffers are written to the console at exit.  Weak
+   default 1, a board overrides it by defining its own const object.  */
+extern const int functrace_console;
+
+/* Pause (0) or resume (1) tracing on all harts, on by default.  */
+void functrace_enable (int __on);
+
+/* Empty the buffer of the calling hart.  */
+void functrace_reset (void);
+
+/* Write all buffers to the console.  */
+void functrace_dump (void);
+
+void __cyg_profile_func_enter (void *__fn, void *__call_site)
+  __attribute__ ((no_instrument_function));
+void __cyg_profile_func_exit (void *__fn, void *__call_site)
+  __attribute__ ((no_instrument_function));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MACHINE_FUNCTRACE_H */
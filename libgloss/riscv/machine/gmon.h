@@ -0,0 +1,65 @@
+/* Copyright (C) SoCHub Finland 2024
+
+   This copyrighted material is made available to anyone wishing to use,
+   modify, copy, or redistribute it subject to the terms and conditions
+   of the FreeBSD License.   This program is distributed in the hope that
+   it will be useful, but WITHOUT ANY WARRANTY expressed or implied,
+   including the implied warranties of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  A copy of this license is available at
+   http://www.opensource.org/licenses.
+*/
+
+/* PC-sampling profiler.
+
+   While profiling, a machine timer tick on the profiled hart records the
+   interrupted pc in a histogram over the text segment, gmon_rate times
+   per second.  No compiler instrumentation is needed.  Linking with -p
+   or -pg starts profiling of the whole program before main; otherwise
+   monstartup () and _mcleanup () can bracket any part of it.
+
+   _mcleanup () turns the histogram into a gmon.out image for gprof,
+   kept in memory at __gmon_image (__gmon_image_size bytes) for a
+   debugger:
+
+     (gdb) dump binary memory gmon.out __gmon_image \
+	     __gmon_image + __gmon_image_size
+
+   and, unless the board sets gmon_console to 0, also written to the
+   console as a hex dump that libgloss/riscv/tools/gmon_extract.py turns
+   back into gmon.out.  Call arcs are not recorded, so gprof shows the
+   flat profile only.  */
+
+#ifndef _MACHINE_GMON_H
+#define _MACHINE_GMON_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Samples per second.  Weak default 1000, a board overrides it by
+   defining its own const object, as with timebase_freq.  */
+extern const unsigned long gmon_rate;
+
+/* Whether _mcleanup () writes the image to the console.  Weak default 1. */
+extern const int gmon_console;
+
+/* The gmon.out image, valid after _mcleanup ().  */
+extern char *__gmon_image;
+extern size_t __gmon_image_size;
+
+/* Start sampling pcs in [lowpc, highpc) on the calling hart.  */
+void monstartup (unsigned long __lowpc, unsigned long __highpc);
+
+/* Pause (0) or resume (1) sampling.  */
+void moncontrol (int __mode);
+
+/* Stop sampling and produce the gmon.out image.  */
+void _mcleanup (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MACHINE_GMON_H */
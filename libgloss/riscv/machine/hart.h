@@ -0,0 +1,50 @@
+/* Copyright (C) SoCHub Finland 2024
+
+   This copyrighted material is made available to anyone wishing to use,
+   modify, copy, or redistribute it subject to the terms and conditions
+   of the FreeBSD License.   This program is distributed in the hope that
+   it will be useful, but WITHOUT ANY WARRANTY expressed or implied,
+   including the implied warranties of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  A copy of this license is available at
+   http://www.opensource.org/licenses.
+*/
+
+/* Multi-hart support.
+
+   Only hart 0 runs the C runtime initialization and main.  crt0 gives
+   every other hart its own stack and parks it in WFI until hart 0 hands
+   it a function with hart_start.  When that function returns, the hart
+   parks again and can be started anew.  */
+
+#ifndef _MACHINE_HART_H
+#define _MACHINE_HART_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static inline unsigned long
+hart_id (void)
+{
+  unsigned long __id;
+
+  __asm__ volatile ("csrr %0, mhartid" : "=r" (__id));
+  return __id;
+}
+
+/* Number of harts crt0 manages, __hart_count in the linker script.  */
+unsigned long hart_count (void);
+
+/* Run fn (arg) on the parked hart hartid.  Returns 0 on success, or -1
+   with errno set to EINVAL for an invalid hart and EBUSY if the hart is
+   still running a previous function.  */
+int hart_start (unsigned long __hartid, void (*__fn) (void *), void *__arg);
+
+/* Nonzero while hartid runs a function given to hart_start.  */
+int hart_busy (unsigned long __hartid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MACHINE_HART_H */
@@ -0,0 +1,64 @@
+/* Copyright (C) SoCHub Finland 2024
+
+   This copyrighted material is made available to anyone wishing to use,
+   modify, copy, or redistribute it subject to the terms and conditions
+   of the FreeBSD License.   This program is distributed in the hope that
+   it will be useful, but WITHOUT ANY WARRANTY expressed or implied,
+   including the implied warranties of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  A copy of this license is available at
+   http://www.opensource.org/licenses.
+*/
+
+/* Placement of heap memory in regions of different latency.
+
+   The linker script defines one address range per region:
+
+     HEAP_DRAM       _heap_start .. _heap_end, the heap of malloc
+     HEAP_FAST_SRAM  _sram_heap_start .. _sram_heap_end, empty unless
+                     set at link time (see headsail.ld)
+
+   malloc, free and the rest of the C library keep using HEAP_DRAM
+   through _sbrk.  malloc_region places an allocation in a given region,
+   so that a hot working set can be kept in low-latency memory while
+   bulk buffers stay in DRAM:
+
+     float *acc = malloc_region (HEAP_FAST_SRAM, 4096);
+     ...
+     free_region (acc);
+
+   The region is a hint: when it is empty or full, the memory comes from
+   malloc instead.  heap_region_of tells where a block ended up.  */
+
+#ifndef _MACHINE_HEAP_H
+#define _MACHINE_HEAP_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HEAP_DRAM		0
+#define HEAP_FAST_SRAM		1
+#define HEAP_REGIONS		2
+
+/* size bytes, aligned to 16, preferably in region.  Returns NULL with
+   errno set to ENOMEM if no region has room.  */
+void *malloc_region (int __region, size_t __size);
+
+/* Release a block from malloc_region.  Blocks from malloc are passed on
+   to free.  */
+void free_region (void *__ptr);
+
+/* Region holding ptr, or -1 if it is in none of them */
+int heap_region_of (const void *__ptr);
+
+/* Bytes left in region: for HEAP_DRAM the room above the break of
+   malloc, for the others also the freed blocks.  */
+size_t heap_region_avail (int __region);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MACHINE_HEAP_H */
@@ -0,0 +1,49 @@
+/* Copyright (C) SoCHub Finland 2024
+
+   This copyrighted material is made available to anyone wishing to use,
+   modify, copy, or redistribute it subject to the terms and conditions
+   of the FreeBSD License.   This program is distributed in the hope that
+   it will be useful, but WITHOUT ANY WARRANTY expressed or implied,
+   including the implied warranties of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  A copy of this license is available at
+   http://www.opensource.org/licenses.
+*/
+
+/* Host file access in simulation.
+
+   Linking with -specs=semihost.specs (RISC-V semihosting, for QEMU and
+   debuggers) or -specs=htif.specs (the HTIF syscall proxy of Spike and
+   other fesvr-based simulators) sends the console and all file calls to
+   the host instead of the UART and the RAM filesystem.  Every host
+   request stops the simulated hart, so its cost is in the number of
+   requests rather than in the bytes moved: read and write pass any
+   length in one request, host files report a large st_blksize so that
+   stdio buffers them in big chunks, and the functions below load a
+   whole file with a single read.
+
+   These functions only exist in the libsemihost and libhtif libraries.  */
+
+#ifndef _MACHINE_HOSTIO_H
+#define _MACHINE_HOSTIO_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Read the host file at path into buf, at most size bytes, with one host
+   read.  Returns the number of bytes read, or -1 with errno set.  */
+ssize_t hostio_load (const char *__path, void *__buf, size_t __size);
+
+/* Read the whole host file at path into a buffer from malloc, and store
+   its size in *size.  Returns the buffer, to be released with free, or
+   NULL with errno set.  */
+void *hostio_load_alloc (const char *__path, size_t *__size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MACHINE_HOSTIO_H */
@@ -0,0 +1,126 @@
+/* Copyright (C) SoCHub Finland 2024
+
+   This copyrighted material is made available to anyone wishing to use,
+   modify, copy, or redistribute it subject to the terms and conditions
+   of the FreeBSD License.   This program is distributed in the hope that
+   it will be useful, but WITHOUT ANY WARRANTY expressed or implied,
+   including the implied warranties of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  A copy of this license is available at
+   http://www.opensource.org/licenses.
+*/
+
+/* Hardware performance counters.
+
+   Counter numbers follow the CSR numbering: PERF_CYCLE (mcycle),
+   PERF_INSTRET (minstret) and 3 to 31 for mhpmcounter3..31.  The two
+   fixed counters always count.  An hpm counter is given an event with
+   perf_event (), which writes the event selector to its mhpmevent CSR.
+   Event encodings are core specific.  A core that does not implement the
+   counter ties mhpmevent to zero (spike, QEMU without the event), and
+   perf_event () then fails and the counter reads as zero, so the same
+   code runs everywhere.
+
+   A region accumulates the counts between perf_start () and perf_stop ()
+   over any number of calls:
+
+     static struct perf_region r = PERF_REGION_INIT ("memcpy 4k");
+
+     perf_event (3, 0x1, "dc miss");
+     for (i = 0; i < 100; i++)
+       {
+	 perf_start (&r);
+	 memcpy (dst, src, 4096);
+	 perf_stop (&r);
+       }
+     perf_report ();
+
+   PERF_SCOPE (name) does the same for the rest of the enclosing block.
+   perf_report () prints every region used so far as a table on stdout:
+   calls, cycles, instructions, IPC and the counts of the events
+   programmed with perf_event ().
+
+   Counters and mhpmevent are per hart.  Events are programmed on the
+   calling hart and a region must be started and stopped on one hart at
+   a time.  */
+
+#ifndef _MACHINE_PERF_H
+#define _MACHINE_PERF_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PERF_CYCLE		0
+#define PERF_INSTRET		2
+#define PERF_HPM_FIRST		3
+#define PERF_HPM_LAST		31
+
+/* Events a region records besides cycles and instructions.  */
+#define PERF_MAX_EVENTS		4
+
+struct perf_region
+{
+  const char *name;
+  unsigned long calls;
+  uint64_t start[2 + PERF_MAX_EVENTS];
+  uint64_t total[2 + PERF_MAX_EVENTS];
+  struct perf_region *next;
+  int listed;
+};
+
+#define PERF_REGION_INIT(name) { (name), 0, { 0 }, { 0 }, 0, 0 }
+
+/* Count event on hpm counter (3..31) of the calling hart and record it
+   in the regions, under the given name in perf_report ().  Returns 0, or
+   -1 if the counter is not implemented or PERF_MAX_EVENTS are already
+   recorded.  Events should be set up before any region is started.  */
+int perf_event (unsigned int counter, unsigned long event, const char *name);
+
+/* Stop counting every event set with perf_event ().  */
+void perf_event_reset (void);
+
+/* Nonzero if the counter counts on this hart.  */
+int perf_available (unsigned int counter);
+
+/* Current value of a counter, 0 if it is not implemented.  */
+uint64_t perf_read (unsigned int counter);
+
+void perf_start (struct perf_region *__region);
+void perf_stop (struct perf_region *__region);
+
+/* Clear the totals of every region.  */
+void perf_reset (void);
+
+/* Print the totals of every region on stdout.  */
+void perf_report (void);
+
+static inline void
+__perf_scope_end (struct perf_region **__region)
+{
+  perf_stop (*__region);
+}
+
+static inline struct perf_region *
+__perf_scope_begin (struct perf_region *__region)
+{
+  perf_start (__region);
+  return __region;
+}
+
+#define __PERF_CAT(a, b) __PERF_CAT_ (a, b)
+#define __PERF_CAT_(a, b) a##b
+
+#define PERF_SCOPE(name)						\
+  static struct perf_region __PERF_CAT (__perf_region_, __LINE__)	\
+    = PERF_REGION_INIT (name);						\
+  struct perf_region *__PERF_CAT (__perf_scope_, __LINE__)		\
+    __attribute__ ((cleanup (__perf_scope_end), unused))		\
+    = __perf_scope_begin (&__PERF_CAT (__perf_region_, __LINE__))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MACHINE_PERF_H */
@@ -0,0 +1,64 @@
+/* Copyright (C) SoCHub Finland 2024
+
+   This copyrighted material is made available to anyone wishing to use,
+   modify, copy, or redistribute it subject to the terms and conditions
+   of the FreeBSD License.   This program is distributed in the hope that
+   it will be useful, but WITHOUT ANY WARRANTY expressed or implied,
+   including the implied warranties of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  A copy of this license is available at
+   http://www.opensource.org/licenses.
+*/
+
+/* Read-only filesystem linked into the program.
+
+   libgloss/riscv/tools/mkromfs.py packs host files into an image that is
+   linked into the .romfs section; headsail.ld places it with the other
+   read-only data.  open, read, lseek, fstat and stat serve its files
+   like any other file, and romfs_map gives direct access to the bytes of
+   a file without copying them.  Several images may be linked, each is
+   padded to ROMFS_ALIGN bytes.
+
+   An image is a header, the directory sorted by name, the names, and the
+   file data, each file aligned as requested from mkromfs.py (16 bytes by
+   default).  All offsets are from the start of the image, all fields are
+   little-endian.  */
+
+#ifndef _MACHINE_ROMFS_H
+#define _MACHINE_ROMFS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ROMFS_MAGIC		0x53464f52	/* "ROFS" */
+#define ROMFS_ALIGN		64
+
+struct romfs_header
+{
+  uint32_t magic;
+  uint32_t count;		/* Entries in the directory */
+  uint32_t size;		/* Bytes in the image, before padding */
+  uint32_t reserved;
+};
+
+struct romfs_entry
+{
+  uint32_t name;		/* Offset of the NUL-terminated path */
+  uint32_t offset;		/* Offset of the data */
+  uint32_t size;		/* Bytes of data */
+  uint32_t reserved;
+};
+
+/* Address of the contents of the file at path, and its size in *size.
+   The bytes stay valid for the whole run of the program.  Returns NULL
+   with errno set to ENOENT if there is no such file.  */
+const void *romfs_map (const char *__path, size_t *__size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MACHINE_ROMFS_H */
@@ -0,0 +1,49 @@
+/* Copyright (C) SoCHub Finland 2024
+
+   This copyrighted material is made available to anyone wishing to use,
+   modify, copy, or redistribute it subject to the terms and conditions
+   of the FreeBSD License.   This program is distributed in the hope that
+   it will be useful, but WITHOUT ANY WARRANTY expressed or implied,
+   including the implied warranties of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  A copy of this license is available at
+   http://www.opensource.org/licenses.
+*/
+
+/* Stack high-water marks.
+
+   Linked with -Wl,--defsym=__stack_fill=1, crt0 fills the stack of every
+   hart with STACK_PATTERN before it runs any code on it.  The functions
+   below scan a stack from its bottom for the first word that differs
+   from the pattern, which gives the deepest use of the stack so far,
+   including the TLS block at its top.  A frame that skips words without
+   writing them can hide a little of its depth, so leave some margin when
+   sizing __stack_size from the result.
+
+   Without __stack_fill the functions return 0.  */
+
+#ifndef _MACHINE_STACK_H
+#define _MACHINE_STACK_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STACK_PATTERN		0x4b435453	/* "STCK" */
+
+/* Deepest use of the calling hart's stack in bytes */
+size_t stack_high_water (void);
+
+/* The same for the stack of hart */
+size_t stack_high_water_hart (unsigned long __hart);
+
+/* Print the high-water mark of every hart to the console:
+     stack hart 0: 2912 of 16384 bytes  */
+void stack_report (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MACHINE_STACK_H */
@@ -15,6 +15,8 @@
 #define SYS_getcwd 17
 #define SYS_dup 23
 #define SYS_fcntl 25
+#define SYS_unlinkat 35
+#define SYS_renameat 38
 #define SYS_faccessat 48
 #define SYS_chdir 49
 #define SYS_openat 56
@@ -0,0 +1,117 @@
+/* Copyright (C) SoCHub Finland 2024
+
+   This copyrighted material is made available to anyone wishing to use,
+   modify, copy, or redistribute it subject to the terms and conditions
+   of the FreeBSD License.   This program is distributed in the hope that
+   it will be useful, but WITHOUT ANY WARRANTY expressed or implied,
+   including the implied warranties of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  A copy of this license is available at
+   http://www.opensource.org/licenses.
+*/
+
+/* Machine-mode traps and interrupts.
+
+   crt0 installs a vectored trap table on every hart.  Interrupt cause n
+   (mcause without the interrupt bit, below TRAP_CAUSES) jumps straight
+   to a stub that saves the caller-saved registers and calls the C
+   handler registered for n, so handlers are ordinary C functions.  The
+   table is shared by all harts.  By default the machine timer interrupt
+   drives the sleep functions and the profiler, and the external
+   interrupt dispatches the PLIC sources registered with
+   trap_set_external; any other interrupt, including the platform
+   causes from TRAP_CAUSES up, is disabled in mie when it first occurs.
+
+   Synchronous exceptions save all integer registers in a struct
+   trap_frame, which the handler may modify: execution resumes at
+   frame->mepc with the registers of the frame.  Without a handler an
+   exception stops the hart.
+
+   Handlers run with interrupts masked.  */
+
+#ifndef _MACHINE_TRAP_H
+#define _MACHINE_TRAP_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of interrupt and exception causes with a handler slot */
+#define TRAP_CAUSES		16
+
+/* Standard machine-mode interrupt causes */
+#define TRAP_IRQ_SOFT		3
+#define TRAP_IRQ_TIMER		7
+#define TRAP_IRQ_EXT		11
+
+struct trap_frame
+{
+  uintptr_t x[32];		/* x[0] is unused, x[2] is the sp to resume */
+  uintptr_t mepc;
+  uintptr_t mcause;
+  uintptr_t mtval;
+};
+
+/* Interrupt handler, called with the cause and the interrupted pc.  */
+typedef void (*trap_handler_t) (unsigned long __cause, uintptr_t __mepc);
+
+/* Exception handler.  */
+typedef void (*trap_exception_t) (struct trap_frame *__frame);
+
+/* Install fn for interrupt cause and enable the cause in mie of the
+   calling hart, or with fn NULL restore the default handler and disable
+   it.  Replacing the timer handler disables the sleep functions and the
+   profiler.  Returns 0, or -1 with errno set to EINVAL for an invalid
+   cause.  */
+int trap_set_interrupt (unsigned int __cause, trap_handler_t __fn);
+
+/* Install fn for exception cause, NULL stops the hart again.  Returns 0,
+   or -1 with errno set to EINVAL for an invalid cause.  */
+int trap_set_exception (unsigned int __cause, trap_exception_t __fn);
+
+/* Call fn for PLIC interrupt source, enable the source with the given
+   priority for the calling hart and enable external interrupts in mie.
+   With fn NULL the source is disabled.  Returns 0, or -1 with errno set
+   to EINVAL for a source of 0 or beyond PLIC_SOURCES.  */
+int trap_set_external (unsigned int __source,
+		       void (*__fn) (unsigned int __source),
+		       unsigned int __priority);
+
+/* Trap latency of one interrupt cause on one hart, in mcycle cycles.
+   entry counts from the first instruction of the trap stub to the call
+   of the handler, handler the time spent in it.  For the machine timer
+   response is the time from mtime reaching mtimecmp to the handler,
+   which includes the time interrupts were masked; it is zero for other
+   causes, whose assertion time is unknown.  */
+struct trap_latency
+{
+  uint32_t count;
+  uint32_t entry_min;
+  uint32_t entry_max;
+  uint32_t handler_max;
+  uint64_t entry_total;
+  uint64_t handler_total;
+  uint64_t response_max;
+};
+
+/* Start (1) or stop (0) measuring the latency of all interrupts.  The
+   measurement adds the bookkeeping to every interrupt, so it is off
+   by default.  */
+void trap_latency_enable (int __on);
+
+/* Copy the statistics of cause on the calling hart to stats.  Returns
+   0, or -1 with errno set to EINVAL for an invalid cause.  */
+int trap_latency_get (unsigned int __cause, struct trap_latency *__stats);
+
+/* Clear the statistics of the calling hart.  */
+void trap_latency_reset (void);
+
+/* Print the statistics of the calling hart to stdout.  */
+void trap_latency_report (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MACHINE_TRAP_H */
@@ -0,0 +1,50 @@
+/* Copyright (C) SoCHub Finland 2024
+
+   This copyrighted material is made available to anyone wishing to use,
+   modify, copy, or redistribute it subject to the terms and conditions
+   of the FreeBSD License.   This program is distributed in the hope that
+   it will be useful, but WITHOUT ANY WARRANTY expressed or implied,
+   including the implied warranties of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  A copy of this license is available at
+   http://www.opensource.org/licenses.
+*/
+
+#ifndef _MACHINE_UART_H
+#define _MACHINE_UART_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of console bytes queued but not yet handed to the UART. */
+size_t uart_tx_pending (void);
+
+/* Wait until all queued console output has left the transmitter. */
+void uart_flush (void);
+
+/* Flags for uart_rx_mode. */
+#define UART_RX_ECHO		0x1	/* Echo received bytes to the console.  */
+#define UART_RX_NONBLOCK	0x2	/* Never wait, fail with EAGAIN instead.  */
+
+/* Set how reads from stdin wait for input, following termios in
+   non-canonical mode: VMIN is the number of bytes a read waits for and
+   VTIME a timeout in tenths of a second.  The default is VMIN 1,
+   VTIME 0 with echo enabled.  */
+int uart_rx_mode (unsigned int vmin, unsigned int vtime, unsigned int flags);
+
+/* Current uart_rx_mode flags.  */
+unsigned int uart_rx_flags (void);
+
+/* Number of received bytes waiting to be read.  */
+size_t uart_rx_pending (void);
+
+/* Number of received bytes lost to a full ring or a FIFO overrun.  */
+size_t uart_rx_lost (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MACHINE_UART_H */
@@ -1,12 +1,159 @@
-#include <machine/syscall.h>
-#include <sys/time.h>
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * Sleeping for Headsail.
+ *
+ * A sleeping hart arms its machine timer (timer.c) with the wakeup time
+ * and waits in WFI. Interrupts stay globally disabled around the WFI, as
+ * in __hart_park(), so the wakeup does not need to trap; between two
+ * WFIs they are briefly reopened so that other interrupts, such as the
+ * UART or the profiler tick, are still serviced. The hart leaves the
+ * memory system and the other harts alone while it sleeps.
+ *
+ * Durations are converted to time CSR ticks with timebase_freq and
+ * rounded up, so a sleep never ends early. There are no signals, so a
+ * sleep is never interrupted and the remaining time is always zero.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <machine/cycles.h>
+#include "encoding.h"
+#include "timer.h"
+
+#define NSEC_PER_SEC	1000000000ULL
+
+static int
+timespec_valid(const struct timespec *ts)
+{
+  return ts->tv_sec >= 0 && ts->tv_nsec >= 0
+	 && ts->tv_nsec < (long)NSEC_PER_SEC;
+}
+
+static uint64_t
+timespec_to_ticks(const struct timespec *ts)
+{
+  return (uint64_t)ts->tv_sec * timebase_freq
+	 + ((uint64_t)ts->tv_nsec * timebase_freq + NSEC_PER_SEC - 1)
+	   / NSEC_PER_SEC;
+}
+
+/* Wait in WFI until the time CSR reaches deadline */
+static void
+sleep_until(uint64_t deadline)
+{
+  unsigned long flags;
+
+  if (timebase_read() >= deadline)
+    return;
+
+  flags = irq_save();
+  timer_wakeup_at(deadline);
+
+  while (timebase_read() < deadline)
+  {
+    __asm__ volatile ("wfi");
+    irq_restore(flags);
+    flags = irq_save();
+  }
+
+  timer_wakeup_at(UINT64_MAX);
+  irq_restore(flags);
+}
+
+static void
+clear_remaining(struct timespec *rmtp)
+{
+  if (rmtp != NULL)
+  {
+    rmtp->tv_sec = 0;
+    rmtp->tv_nsec = 0;
+  }
+}
+
+int
+clock_nanosleep(clockid_t clock_id, int flags, const struct timespec *rqtp,
+		struct timespec *rmtp)
+{
+  struct timespec now;
+  uint64_t start;
+
+  if (!timespec_valid(rqtp))
+    return EINVAL;
+
+  start = timebase_read();
+
+  switch (clock_id)
+  {
+  case CLOCK_MONOTONIC:
+    /* The monotonic clock is the time CSR itself, so an absolute
+       deadline maps to an exact tick and periodic loops do not drift */
+    if (flags & TIMER_ABSTIME)
+      sleep_until(timespec_to_ticks(rqtp));
+    else
+      sleep_until(start + timespec_to_ticks(rqtp));
+    break;
+  case CLOCK_REALTIME:
+    if (flags & TIMER_ABSTIME)
+    {
+      clock_gettime(CLOCK_REALTIME, &now);
+      if (now.tv_sec > rqtp->tv_sec
+	  || (now.tv_sec == rqtp->tv_sec && now.tv_nsec >= rqtp->tv_nsec))
+	break;
+      now.tv_sec = rqtp->tv_sec - now.tv_sec;
+      now.tv_nsec = rqtp->tv_nsec - now.tv_nsec;
+      if (now.tv_nsec < 0)
+      {
+	now.tv_sec--;
+	now.tv_nsec += NSEC_PER_SEC;
+      }
+      sleep_until(start + timespec_to_ticks(&now));
+    }
+    else
+      sleep_until(start + timespec_to_ticks(rqtp));
+    break;
+  default:
+    /* Also CLOCK_PROCESS_CPUTIME_ID, the caller's own CPU-time clock */
+    return EINVAL;
+  }
+
+  if ((flags & TIMER_ABSTIME) == 0)
+    clear_remaining(rmtp);
+  return 0;
+}
 
 int
 nanosleep(const struct timespec *rqtp, struct timespec *rmtp)
 {
-  unsigned long current_time, end_time;
-  asm ("rdtime %0" : "+r" (current_time));
-  end_time = current_time + rqtp->tv_sec * 1000000000ULL + rqtp->tv_nsec;
-  while (current_time <= end_time) asm ("rdtime %0" : "+r" (current_time));
+  int err = clock_nanosleep(CLOCK_MONOTONIC, 0, rqtp, rmtp);
+
+  if (err != 0)
+  {
+    errno = err;
+    return -1;
+  }
+  return 0;
+}
+
+int
+usleep(useconds_t useconds)
+{
+  struct timespec ts;
+
+  ts.tv_sec = useconds / 1000000;
+  ts.tv_nsec = (useconds % 1000000) * 1000;
+  return nanosleep(&ts, NULL);
+}
+
+unsigned
+sleep(unsigned seconds)
+{
+  struct timespec ts;
+
+  ts.tv_sec = seconds;
+  ts.tv_nsec = 0;
+  nanosleep(&ts, NULL);
   return 0;
 }
@@ -0,0 +1,227 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * Hardware performance counters, see <machine/perf.h>.
+ *
+ * The counter CSRs can only be named by constants, so reads and event
+ * writes go through a switch over the counter number. The report goes
+ * through console.h, so that it works with every printf flavour
+ * (newlib-nano has no %llu by default) and does not disturb the stdio
+ * buffers of the program being measured.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <machine/perf.h>
+#include "console.h"
+#include "encoding.h"
+
+#if __riscv_xlen == 32
+#define read_csr64(lo, hi) ({ uint32_t __hi, __lo, __hi2; \
+  do { __hi = read_csr(hi); __lo = read_csr(lo); __hi2 = read_csr(hi); } \
+  while (__hi != __hi2); \
+  ((uint64_t)__hi << 32) | __lo; })
+#else
+#define read_csr64(lo, hi) ((uint64_t)read_csr(lo))
+#endif
+
+#define HPM_COUNTERS(X) \
+  X(3) X(4) X(5) X(6) X(7) X(8) X(9) X(10) X(11) X(12) X(13) X(14) X(15) \
+  X(16) X(17) X(18) X(19) X(20) X(21) X(22) X(23) X(24) X(25) X(26) X(27) \
+  X(28) X(29) X(30) X(31)
+
+/* hpm counters recorded by the regions, and their names */
+static unsigned int perf_counter[PERF_MAX_EVENTS];
+static const char *perf_name[PERF_MAX_EVENTS];
+static unsigned int perf_events;
+
+/* Regions in the order of their first use */
+static struct perf_region *perf_regions;
+static struct perf_region **perf_regions_tail = &perf_regions;
+
+uint64_t
+perf_read(unsigned int counter)
+{
+  switch (counter)
+  {
+    case PERF_CYCLE:
+      return read_csr64(mcycle, mcycleh);
+    case PERF_INSTRET:
+      return read_csr64(minstret, minstreth);
+#define READ_HPM(n) \
+    case n: \
+      return read_csr64(mhpmcounter##n, mhpmcounter##n##h);
+    HPM_COUNTERS(READ_HPM)
+#undef READ_HPM
+    default:
+      return 0;
+  }
+}
+
+/* Write an event selector and return what the CSR kept of it */
+static unsigned long
+set_event(unsigned int counter, unsigned long event)
+{
+  switch (counter)
+  {
+#define WRITE_EVENT(n) \
+    case n: \
+      write_csr(mhpmevent##n, event); \
+      return read_csr(mhpmevent##n);
+    HPM_COUNTERS(WRITE_EVENT)
+#undef WRITE_EVENT
+    default:
+      return 0;
+  }
+}
+
+static unsigned long
+get_event(unsigned int counter)
+{
+  switch (counter)
+  {
+#define READ_EVENT(n) \
+    case n: \
+      return read_csr(mhpmevent##n);
+    HPM_COUNTERS(READ_EVENT)
+#undef READ_EVENT
+    default:
+      return 0;
+  }
+}
+
+int
+perf_available(unsigned int counter)
+{
+  if (counter == PERF_CYCLE || counter == PERF_INSTRET)
+    return 1;
+  return get_event(counter) != 0;
+}
+
+int
+perf_event(unsigned int counter, unsigned long event, const char *name)
+{
+  if (counter < PERF_HPM_FIRST || counter > PERF_HPM_LAST || event == 0
+      || perf_events == PERF_MAX_EVENTS)
+    return -1;
+
+  /* Unimplemented counters have mhpmevent hardwired to zero */
+  if (set_event(counter, event) != event)
+  {
+    set_event(counter, 0);
+    return -1;
+  }
+
+  perf_counter[perf_events] = counter;
+  perf_name[perf_events] = name;
+  perf_events++;
+  return 0;
+}
+
+void
+perf_event_reset(void)
+{
+  while (perf_events > 0)
+  {
+    perf_events--;
+    set_event(perf_counter[perf_events], 0);
+  }
+}
+
+void
+perf_start(struct perf_region *region)
+{
+  unsigned int i;
+
+  if (!region->listed)
+  {
+    region->listed = 1;
+    *perf_regions_tail = region;
+    perf_regions_tail = &region->next;
+  }
+
+  region->calls++;
+
+  /* Cycles last, so that the setup is not counted */
+  for (i = 0; i < perf_events; i++)
+    region->start[2 + i] = perf_read(perf_counter[i]);
+  region->start[1] = read_csr64(minstret, minstreth);
+  region->start[0] = read_csr64(mcycle, mcycleh);
+}
+
+void
+perf_stop(struct perf_region *region)
+{
+  uint64_t cycle = read_csr64(mcycle, mcycleh);
+  uint64_t instret = read_csr64(minstret, minstreth);
+  unsigned int i;
+
+  region->total[0] += cycle - region->start[0];
+  region->total[1] += instret - region->start[1];
+  for (i = 0; i < perf_events; i++)
+    region->total[2 + i] += perf_read(perf_counter[i]) - region->start[2 + i];
+}
+
+void
+perf_reset(void)
+{
+  struct perf_region *r;
+
+  for (r = perf_regions; r != NULL; r = r->next)
+  {
+    r->calls = 0;
+    memset(r->total, 0, sizeof(r->total));
+  }
+}
+
+/* Instructions per cycle with two decimals */
+static void
+put_ipc(uint64_t instret, uint64_t cycles)
+{
+  char ipc[24];
+  char *p = ipc + sizeof(ipc);
+  uint64_t hundredths;
+
+  if (cycles == 0)
+  {
+    console_field("-", 7, 1);
+    return;
+  }
+
+  hundredths = instret * 100 / cycles;
+  *--p = '\0';
+  *--p = '0' + hundredths % 10;
+  *--p = '0' + hundredths / 10 % 10;
+  *--p = '.';
+  console_field(console_utoa(p, hundredths / 100), 7, 1);
+}
+
+void
+perf_report(void)
+{
+  struct perf_region *r;
+  unsigned int i;
+
+  console_field("region", 32, 0);
+  console_field("calls", 12, 1);
+  console_field("cycles", 16, 1);
+  console_field("cycles/call", 16, 1);
+  console_field("instret", 16, 1);
+  console_field("IPC", 7, 1);
+  for (i = 0; i < perf_events; i++)
+    console_field(perf_name[i], 16, 1);
+  console_puts("\n");
+
+  for (r = perf_regions; r != NULL; r = r->next)
+  {
+    console_field(r->name, 32, 0);
+    console_fieldu(r->calls, 12);
+    console_fieldu(r->total[0], 16);
+    console_fieldu(r->calls != 0 ? r->total[0] / r->calls : 0, 16);
+    console_fieldu(r->total[1], 16);
+    put_ipc(r->total[1], r->total[0]);
+    for (i = 0; i < perf_events; i++)
+      console_fieldu(r->total[2 + i], 16);
+    console_puts("\n");
+  }
+}
@@ -0,0 +1,83 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * Minimal driver for the RISC-V Platform-Level Interrupt Controller,
+ * enough to route peripheral interrupts to the machine-mode context of
+ * the calling hart.
+ *
+ * The controller base, the number of contexts per hart and the number of
+ * sources libgloss dispatches are build-time settings (PLIC_BASE,
+ * PLIC_CONTEXTS_PER_HART, PLIC_SOURCES). The defaults follow the SiFive
+ * layout, where context 2 * hartid is the machine-mode context.
+ */
+
+#ifndef _RISCV_PLIC_H
+#define _RISCV_PLIC_H
+
+#include <stdint.h>
+#include "encoding.h"
+
+#ifndef PLIC_BASE
+#define PLIC_BASE				0x0C000000UL
+#endif
+
+#ifndef PLIC_CONTEXTS_PER_HART
+#define PLIC_CONTEXTS_PER_HART	2
+#endif
+
+#ifndef PLIC_SOURCES
+#define PLIC_SOURCES			64
+#endif
+
+#define PLIC_PRIORITY_OFFSET	0x000000
+#define PLIC_ENABLE_OFFSET		0x002000
+#define PLIC_ENABLE_STRIDE		0x80
+#define PLIC_CONTEXT_OFFSET		0x200000
+#define PLIC_CONTEXT_STRIDE		0x1000
+#define PLIC_THRESHOLD			0x0
+#define PLIC_CLAIM				0x4
+
+#define PLIC_REG(off)	(*(volatile uint32_t *)(PLIC_BASE + (off)))
+
+static inline unsigned long
+plic_context(void)
+{
+  return read_csr(mhartid) * PLIC_CONTEXTS_PER_HART;
+}
+
+/* Enable source irq with the given priority for the calling hart */
+static inline void
+plic_enable(unsigned int irq, unsigned int priority)
+{
+  unsigned long ctx = plic_context();
+
+  PLIC_REG(PLIC_PRIORITY_OFFSET + 4 * irq) = priority;
+  PLIC_REG(PLIC_ENABLE_OFFSET + ctx * PLIC_ENABLE_STRIDE + 4 * (irq / 32))
+    |= 1U << (irq % 32);
+  PLIC_REG(PLIC_CONTEXT_OFFSET + ctx * PLIC_CONTEXT_STRIDE
+	   + PLIC_THRESHOLD) = 0;
+}
+
+/* Disable source irq for the calling hart */
+static inline void
+plic_disable(unsigned int irq)
+{
+  PLIC_REG(PLIC_ENABLE_OFFSET + plic_context() * PLIC_ENABLE_STRIDE
+	   + 4 * (irq / 32)) &= ~(1U << (irq % 32));
+}
+
+static inline unsigned int
+plic_claim(void)
+{
+  return PLIC_REG(PLIC_CONTEXT_OFFSET + plic_context() * PLIC_CONTEXT_STRIDE
+		  + PLIC_CLAIM);
+}
+
+static inline void
+plic_complete(unsigned int irq)
+{
+  PLIC_REG(PLIC_CONTEXT_OFFSET + plic_context() * PLIC_CONTEXT_STRIDE
+	   + PLIC_CLAIM) = irq;
+}
+
+#endif /* _RISCV_PLIC_H */
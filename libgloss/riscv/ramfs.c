@@ -0,0 +1,609 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * RAM filesystem, see ramfs.h.
+ *
+ * All state is global and shared by the harts; one spinlock serializes
+ * the calls. The region is laid out on first use, so programs that never
+ * open a file do not touch it.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include "encoding.h"
+#include "ramfs.h"
+
+/* Weak, so that linker scripts without a .ramfs region get none */
+extern char _ramfs_start[] __attribute__((weak));
+extern char _ramfs_end[] __attribute__((weak));
+
+struct ramfs_extent
+{
+  uint32_t start;		/* First block */
+  uint32_t count;		/* Blocks */
+};
+
+struct ramfs_file
+{
+  char name[RAMFS_NAME_MAX];	/* Empty when unused or unlinked */
+  size_t size;
+  unsigned int opens;		/* Descriptors referring to the file */
+  unsigned int extents;
+  uint32_t blocks;		/* Blocks in all extents */
+  struct ramfs_extent extent[RAMFS_EXTENTS];
+};
+
+struct ramfs_fd
+{
+  struct ramfs_file *file;	/* NULL if the descriptor is closed */
+  _off_t offset;
+  int flags;
+};
+
+enum ramfs_copy { RAMFS_COPY_IN, RAMFS_COPY_OUT, RAMFS_ZERO };
+
+static struct ramfs_file ramfs_files[RAMFS_FILES];
+static struct ramfs_fd ramfs_fds[RAMFS_FDS];
+
+static uint32_t *ramfs_bitmap;	/* One bit per block, set if used */
+static char *ramfs_data;
+static uint32_t ramfs_blocks;
+static int ramfs_ready;
+
+static int ramfs_lock_word;
+
+static void
+ramfs_init(void)
+{
+  size_t size = _ramfs_end - _ramfs_start;
+  size_t bitmap;
+
+  /* Every block costs RAMFS_BLOCK bytes and one bit of bitmap */
+  ramfs_blocks = size * 8 / (RAMFS_BLOCK * 8 + 1);
+  bitmap = ((ramfs_blocks + 31) / 32 * 4 + 63) & ~(size_t)63;
+  if (bitmap + (size_t)ramfs_blocks * RAMFS_BLOCK > size)
+    ramfs_blocks = bitmap < size ? (size - bitmap) / RAMFS_BLOCK : 0;
+
+  ramfs_bitmap = (uint32_t *)_ramfs_start;
+  ramfs_data = _ramfs_start + bitmap;
+  memset(ramfs_bitmap, 0, (ramfs_blocks + 31) / 32 * 4);
+  ramfs_ready = 1;
+}
+
+static inline int
+block_used(uint32_t block)
+{
+  return (ramfs_bitmap[block / 32] >> (block % 32)) & 1;
+}
+
+static void
+block_mark(uint32_t start, uint32_t count, int used)
+{
+  uint32_t b;
+
+  for (b = start; b < start + count; b++)
+  {
+    if (used)
+      ramfs_bitmap[b / 32] |= 1U << (b % 32);
+    else
+      ramfs_bitmap[b / 32] &= ~(1U << (b % 32));
+  }
+}
+
+/* Free blocks from start on, counting up to max */
+static uint32_t
+block_free_run(uint32_t start, uint32_t max)
+{
+  uint32_t n = 0;
+
+  while (n < max && start + n < ramfs_blocks && !block_used(start + n))
+    n++;
+  return n;
+}
+
+/* First run of count free blocks, UINT32_MAX if there is none */
+static uint32_t
+block_find(uint32_t count)
+{
+  uint32_t b = 0;
+  uint32_t run;
+
+  while (count <= ramfs_blocks && b <= ramfs_blocks - count)
+  {
+    if (b % 32 == 0 && ramfs_bitmap[b / 32] == 0xFFFFFFFF)
+    {
+      b += 32;
+      continue;
+    }
+    run = block_free_run(b, count);
+    if (run == count)
+      return b;
+    b += run + 1;
+  }
+  return UINT32_MAX;
+}
+
+/* Release the blocks of f beyond its size */
+static void
+file_trim(struct ramfs_file *f)
+{
+  uint32_t keep = (f->size + RAMFS_BLOCK - 1) / RAMFS_BLOCK;
+  struct ramfs_extent *e;
+  unsigned int i;
+
+  for (i = 0; i < f->extents; i++)
+  {
+    e = &f->extent[i];
+    if (keep >= e->count)
+    {
+      keep -= e->count;
+      continue;
+    }
+    block_mark(e->start + keep, e->count - keep, 0);
+    f->blocks -= e->count - keep;
+    e->count = keep;
+    keep = 0;
+  }
+
+  while (f->extents > 0 && f->extent[f->extents - 1].count == 0)
+    f->extents--;
+}
+
+static void
+file_truncate(struct ramfs_file *f)
+{
+  f->size = 0;
+  file_trim(f);
+}
+
+/**
+ * Grow the extents of f to hold end bytes. A new extent is preferably as
+ * large as the file's allocation so far, so the number of extents stays
+ * logarithmic in the file size. When the region gets tight, the unused
+ * tails of the other files are given back first, then smaller runs are
+ * taken. Returns the capacity reached, which is less than end when the
+ * region or the extent list is full.
+ */
+static size_t
+file_reserve(struct ramfs_file *f, size_t end)
+{
+  size_t cap = (size_t)f->blocks * RAMFS_BLOCK;
+  struct ramfs_extent *last;
+  uint32_t need, want, got, start;
+  int trimmed = 0;
+  unsigned int i;
+
+  while (cap < end)
+  {
+    need = (end - cap + RAMFS_BLOCK - 1) / RAMFS_BLOCK;
+    want = need > f->blocks ? need : f->blocks;
+
+    /* Extend the last extent in place if the blocks after it are free */
+    if (f->extents > 0)
+    {
+      last = &f->extent[f->extents - 1];
+      got = block_free_run(last->start + last->count, want);
+      if (got >= need)
+      {
+        block_mark(last->start + last->count, got, 1);
+        last->count += got;
+        f->blocks += got;
+        cap = (size_t)f->blocks * RAMFS_BLOCK;
+        continue;
+      }
+    }
+
+    if (f->extents == RAMFS_EXTENTS)
+      break;
+
+    while ((start = block_find(want)) == UINT32_MAX && want > need)
+      want = want / 2 > need ? want / 2 : need;
+
+    if (start == UINT32_MAX && !trimmed)
+    {
+      /* Reclaim the slack of the other files and try again */
+      for (i = 0; i < RAMFS_FILES; i++)
+        if (&ramfs_files[i] != f)
+          file_trim(&ramfs_files[i]);
+      trimmed = 1;
+      continue;
+    }
+
+    /* Then settle for whatever fragments are left */
+    while (start == UINT32_MAX && want > 1)
+      start = block_find(want /= 2);
+    if (start == UINT32_MAX)
+      break;
+
+    block_mark(start, want, 1);
+    f->extent[f->extents].start = start;
+    f->extent[f->extents].count = want;
+    f->extents++;
+    f->blocks += want;
+    cap = (size_t)f->blocks * RAMFS_BLOCK;
+  }
+  return cap;
+}
+
+/* Copy len bytes at offset of f, which must be within its capacity */
+static void
+file_copy(struct ramfs_file *f, size_t offset, char *buf, size_t len,
+	  enum ramfs_copy dir)
+{
+  struct ramfs_extent *e = f->extent;
+  size_t bytes, n;
+  char *p;
+
+  while (len > 0)
+  {
+    bytes = (size_t)e->count * RAMFS_BLOCK;
+    if (offset >= bytes)
+    {
+      offset -= bytes;
+      e++;
+      continue;
+    }
+
+    n = bytes - offset < len ? bytes - offset : len;
+    p = ramfs_data + (size_t)e->start * RAMFS_BLOCK + offset;
+    if (dir == RAMFS_COPY_IN)
+      memcpy(p, buf, n);
+    else if (dir == RAMFS_COPY_OUT)
+      memcpy(buf, p, n);
+    else
+      memset(p, 0, n);
+
+    if (buf != NULL)
+      buf += n;
+    len -= n;
+    offset = 0;
+    e++;
+  }
+}
+
+static struct ramfs_file *
+file_lookup(const char *path)
+{
+  unsigned int i;
+
+  for (i = 0; i < RAMFS_FILES; i++)
+    if (ramfs_files[i].name[0] != '\0'
+        && strcmp(ramfs_files[i].name, path) == 0)
+      return &ramfs_files[i];
+  return NULL;
+}
+
+static void
+file_stat(struct ramfs_file *f, struct stat *st)
+{
+  memset(st, 0, sizeof(*st));
+  st->st_ino = f - ramfs_files + 1;
+  st->st_mode = S_IFREG | 0666;
+  st->st_nlink = f->name[0] != '\0';
+  st->st_size = f->size;
+  st->st_blksize = RAMFS_BUFSIZE;
+  st->st_blocks = (blkcnt_t)f->blocks * (RAMFS_BLOCK / 512);
+}
+
+static struct ramfs_fd *
+fd_lookup(int fd)
+{
+  if (fd < RAMFS_FD_FIRST || fd >= RAMFS_FD_FIRST + RAMFS_FDS
+      || ramfs_fds[fd - RAMFS_FD_FIRST].file == NULL)
+    return NULL;
+  return &ramfs_fds[fd - RAMFS_FD_FIRST];
+}
+
+int
+ramfs_isfd(int fd)
+{
+  return fd_lookup(fd) != NULL;
+}
+
+int
+ramfs_open(struct _reent *reent, const char *path, int flags, int mode)
+{
+  struct ramfs_file *f;
+  unsigned int i, fd;
+  int err = 0;
+
+  if (path[0] == '\0')
+  {
+    __errno_r(reent) = ENOENT;
+    return -1;
+  }
+  if (strlen(path) >= RAMFS_NAME_MAX)
+  {
+    __errno_r(reent) = ENAMETOOLONG;
+    return -1;
+  }
+
+  spin_lock(&ramfs_lock_word);
+  if (!ramfs_ready)
+    ramfs_init();
+
+  for (fd = 0; fd < RAMFS_FDS && ramfs_fds[fd].file != NULL; fd++);
+  if (fd == RAMFS_FDS)
+  {
+    err = EMFILE;
+    goto out;
+  }
+
+  f = file_lookup(path);
+  if (f != NULL && (flags & O_CREAT) && (flags & O_EXCL))
+  {
+    err = EEXIST;
+    goto out;
+  }
+  if (f == NULL)
+  {
+    if (!(flags & O_CREAT))
+    {
+      err = ENOENT;
+      goto out;
+    }
+    for (i = 0; i < RAMFS_FILES; i++)
+      if (ramfs_files[i].name[0] == '\0' && ramfs_files[i].opens == 0)
+        break;
+    if (i == RAMFS_FILES)
+    {
+      err = ENOSPC;
+      goto out;
+    }
+    f = &ramfs_files[i];
+    memset(f, 0, sizeof(*f));
+    strcpy(f->name, path);
+  }
+  else if ((flags & O_TRUNC) && (flags & O_ACCMODE) != O_RDONLY)
+    file_truncate(f);
+
+  f->opens++;
+  ramfs_fds[fd].file = f;
+  ramfs_fds[fd].offset = 0;
+  ramfs_fds[fd].flags = flags;
+
+out:
+  spin_unlock(&ramfs_lock_word);
+  if (err != 0)
+  {
+    __errno_r(reent) = err;
+    return -1;
+  }
+  return RAMFS_FD_FIRST + fd;
+}
+
+int
+ramfs_close(struct _reent *reent, int fd)
+{
+  struct ramfs_fd *d;
+  struct ramfs_file *f;
+
+  spin_lock(&ramfs_lock_word);
+  if ((d = fd_lookup(fd)) == NULL)
+  {
+    spin_unlock(&ramfs_lock_word);
+    __errno_r(reent) = EBADF;
+    return -1;
+  }
+
+  f = d->file;
+  d->file = NULL;
+  /* The blocks of an unlinked file are freed with its last descriptor */
+  if (--f->opens == 0 && f->name[0] == '\0')
+    file_truncate(f);
+  else
+    file_trim(f);
+  spin_unlock(&ramfs_lock_word);
+  return 0;
+}
+
+_ssize_t
+ramfs_read(struct _reent *reent, int fd, void *buf, size_t len)
+{
+  struct ramfs_fd *d;
+  size_t n = 0;
+
+  spin_lock(&ramfs_lock_word);
+  if ((d = fd_lookup(fd)) == NULL || (d->flags & O_ACCMODE) == O_WRONLY)
+  {
+    spin_unlock(&ramfs_lock_word);
+    __errno_r(reent) = EBADF;
+    return -1;
+  }
+
+  if ((size_t)d->offset < d->file->size)
+  {
+    n = d->file->size - d->offset;
+    if (n > len)
+      n = len;
+    file_copy(d->file, d->offset, buf, n, RAMFS_COPY_OUT);
+    d->offset += n;
+  }
+  spin_unlock(&ramfs_lock_word);
+  return n;
+}
+
+_ssize_t
+ramfs_write(struct _reent *reent, int fd, const void *buf, size_t len)
+{
+  struct ramfs_fd *d;
+  struct ramfs_file *f;
+  size_t offset, cap;
+  int err = 0;
+
+  spin_lock(&ramfs_lock_word);
+  if ((d = fd_lookup(fd)) == NULL || (d->flags & O_ACCMODE) == O_RDONLY)
+  {
+    err = EBADF;
+    goto out;
+  }
+
+  f = d->file;
+  if (d->flags & O_APPEND)
+    d->offset = f->size;
+  offset = d->offset;
+  if (len == 0)
+    goto out;
+  if (offset + len < offset)
+  {
+    err = EFBIG;
+    goto out;
+  }
+
+  /* Write what fits, a short count tells the caller the rest failed */
+  cap = file_reserve(f, offset + len);
+  if (cap <= offset)
+  {
+    err = ENOSPC;
+    goto out;
+  }
+  if (offset + len > cap)
+    len = cap - offset;
+
+  /* A write past the end leaves a hole, which reads as zeros */
+  if (offset > f->size)
+    file_copy(f, f->size, NULL, offset - f->size, RAMFS_ZERO);
+
+  file_copy(f, offset, (char *)buf, len, RAMFS_COPY_IN);
+  d->offset = offset + len;
+  if ((size_t)d->offset > f->size)
+    f->size = d->offset;
+
+out:
+  spin_unlock(&ramfs_lock_word);
+  if (err != 0)
+  {
+    __errno_r(reent) = err;
+    return -1;
+  }
+  return len;
+}
+
+_off_t
+ramfs_lseek(struct _reent *reent, int fd, _off_t offset, int whence)
+{
+  struct ramfs_fd *d;
+  _off_t base;
+
+  spin_lock(&ramfs_lock_word);
+  if ((d = fd_lookup(fd)) == NULL)
+  {
+    spin_unlock(&ramfs_lock_word);
+    __errno_r(reent) = EBADF;
+    return -1;
+  }
+
+  switch (whence)
+  {
+    case SEEK_SET:
+      base = 0;
+      break;
+    case SEEK_CUR:
+      base = d->offset;
+      break;
+    case SEEK_END:
+      base = d->file->size;
+      break;
+    default:
+      base = -1;
+      break;
+  }
+
+  if (base < 0 || base + offset < 0)
+  {
+    spin_unlock(&ramfs_lock_word);
+    __errno_r(reent) = EINVAL;
+    return -1;
+  }
+
+  d->offset = base + offset;
+  spin_unlock(&ramfs_lock_word);
+  return d->offset;
+}
+
+int
+ramfs_fstat(struct _reent *reent, int fd, struct stat *st)
+{
+  struct ramfs_fd *d;
+
+  spin_lock(&ramfs_lock_word);
+  if ((d = fd_lookup(fd)) == NULL)
+  {
+    spin_unlock(&ramfs_lock_word);
+    __errno_r(reent) = EBADF;
+    return -1;
+  }
+  file_stat(d->file, st);
+  spin_unlock(&ramfs_lock_word);
+  return 0;
+}
+
+int
+ramfs_stat(struct _reent *reent, const char *path, struct stat *st)
+{
+  struct ramfs_file *f;
+
+  spin_lock(&ramfs_lock_word);
+  if ((f = file_lookup(path)) == NULL)
+  {
+    spin_unlock(&ramfs_lock_word);
+    __errno_r(reent) = ENOENT;
+    return -1;
+  }
+  file_stat(f, st);
+  spin_unlock(&ramfs_lock_word);
+  return 0;
+}
+
+int
+ramfs_unlink(struct _reent *reent, const char *path)
+{
+  struct ramfs_file *f;
+
+  spin_lock(&ramfs_lock_word);
+  if ((f = file_lookup(path)) == NULL)
+  {
+    spin_unlock(&ramfs_lock_word);
+    __errno_r(reent) = ENOENT;
+    return -1;
+  }
+  f->name[0] = '\0';
+  if (f->opens == 0)
+    file_truncate(f);
+  spin_unlock(&ramfs_lock_word);
+  return 0;
+}
+
+int
+ramfs_rename(struct _reent *reent, const char *old, const char *new)
+{
+  struct ramfs_file *f, *g;
+
+  if (strlen(new) >= RAMFS_NAME_MAX)
+  {
+    __errno_r(reent) = ENAMETOOLONG;
+    return -1;
+  }
+
+  spin_lock(&ramfs_lock_word);
+  if ((f = file_lookup(old)) == NULL || new[0] == '\0')
+  {
+    spin_unlock(&ramfs_lock_word);
+    __errno_r(reent) = ENOENT;
+    return -1;
+  }
+
+  /* An existing target is replaced, as by unlink */
+  if ((g = file_lookup(new)) != NULL && g != f)
+  {
+    g->name[0] = '\0';
+    if (g->opens == 0)
+      file_truncate(g);
+  }
+  strcpy(f->name, new);
+  spin_unlock(&ramfs_lock_word);
+  return 0;
+}
@@ -0,0 +1,68 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * RAM filesystem behind the file syscalls.
+ *
+ * Files live in the .ramfs region of the linker script (__ramfs_size
+ * bytes, 1 MiB by default), which is split into RAMFS_BLOCK byte blocks
+ * tracked by a bitmap at its start. A file is a list of at most
+ * RAMFS_EXTENTS extents, runs of contiguous blocks; every time a file
+ * grows beyond its extents it gets a new one at least as large as all
+ * previous ones together, or the last extent is extended in place, so
+ * even large files have few extents and reads and writes are plain
+ * memcpy calls. The namespace is flat: a path is just the file name.
+ *
+ * Descriptors of RAM files start at 3, after the console. The functions
+ * follow the _*_r conventions of syscalls.c: -1 and errno in reent on
+ * error.
+ */
+
+#ifndef _RISCV_RAMFS_H
+#define _RISCV_RAMFS_H
+
+#include <reent.h>
+#include <sys/stat.h>
+
+#ifndef RAMFS_BLOCK
+#define RAMFS_BLOCK			1024
+#endif
+
+#ifndef RAMFS_EXTENTS
+#define RAMFS_EXTENTS		16
+#endif
+
+/* Files that can exist, and descriptors that can be open, at once */
+#ifndef RAMFS_FILES
+#define RAMFS_FILES			32
+#endif
+
+#ifndef RAMFS_FDS
+#define RAMFS_FDS			16
+#endif
+
+#ifndef RAMFS_NAME_MAX
+#define RAMFS_NAME_MAX		32
+#endif
+
+/* st_blksize, and so the stdio buffer size, of RAM files */
+#ifndef RAMFS_BUFSIZE
+#define RAMFS_BUFSIZE		4096
+#endif
+
+#define RAMFS_FD_FIRST		3
+
+int ramfs_open(struct _reent *reent, const char *path, int flags, int mode);
+int ramfs_close(struct _reent *reent, int fd);
+_ssize_t ramfs_read(struct _reent *reent, int fd, void *buf, size_t len);
+_ssize_t ramfs_write(struct _reent *reent, int fd, const void *buf,
+		     size_t len);
+_off_t ramfs_lseek(struct _reent *reent, int fd, _off_t offset, int whence);
+int ramfs_fstat(struct _reent *reent, int fd, struct stat *st);
+int ramfs_stat(struct _reent *reent, const char *path, struct stat *st);
+int ramfs_unlink(struct _reent *reent, const char *path);
+int ramfs_rename(struct _reent *reent, const char *old, const char *new);
+
+/* Nonzero if fd is an open RAM file */
+int ramfs_isfd(int fd);
+
+#endif /* _RISCV_RAMFS_H */
@@ -0,0 +1,280 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * Read-only filesystem, see romfs.h.
+ *
+ * The images are never written, so lookups need no locking; only the
+ * claim of a descriptor slot is atomic. A descriptor itself must not be
+ * used by several harts at once, as with any file.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include "romfs.h"
+
+/* Weak, so that linker scripts without a .romfs section get no files */
+extern const char _romfs_start[] __attribute__((weak));
+extern const char _romfs_end[] __attribute__((weak));
+
+struct romfs_fd
+{
+  int open;
+  const struct romfs_entry *entry;
+  const char *data;
+  _off_t offset;
+};
+
+static struct romfs_fd romfs_fds[ROMFS_FDS];
+
+/* Directory entry of path, with the image containing it in *image */
+static const struct romfs_entry *
+romfs_find(const char *path, const char **image)
+{
+  const struct romfs_header *h;
+  const struct romfs_entry *dir;
+  const char *p = _romfs_start;
+  uint32_t lo, hi, mid;
+  int cmp;
+
+  while (*path == '/')
+    path++;
+
+  while (p + sizeof(*h) <= _romfs_end)
+  {
+    h = (const struct romfs_header *)p;
+    if (h->magic != ROMFS_MAGIC)
+      break;
+
+    dir = (const struct romfs_entry *)(h + 1);
+    lo = 0;
+    hi = h->count;
+    while (lo < hi)
+    {
+      mid = lo + (hi - lo) / 2;
+      cmp = strcmp(path, p + dir[mid].name);
+      if (cmp == 0)
+      {
+        *image = p;
+        return &dir[mid];
+      }
+      if (cmp < 0)
+        hi = mid;
+      else
+        lo = mid + 1;
+    }
+
+    p += (h->size + ROMFS_ALIGN - 1) & ~(ROMFS_ALIGN - 1);
+  }
+  return NULL;
+}
+
+static void
+romfs_fill_stat(const struct romfs_entry *e, struct stat *st)
+{
+  memset(st, 0, sizeof(*st));
+  st->st_ino = (uintptr_t)e;
+  st->st_mode = S_IFREG | 0444;
+  st->st_nlink = 1;
+  st->st_size = e->size;
+  st->st_blksize = ROMFS_BUFSIZE;
+  st->st_blocks = (e->size + 511) / 512;
+}
+
+static struct romfs_fd *
+fd_lookup(int fd)
+{
+  if (fd < ROMFS_FD_FIRST || fd >= ROMFS_FD_FIRST + ROMFS_FDS
+      || !romfs_fds[fd - ROMFS_FD_FIRST].open)
+    return NULL;
+  return &romfs_fds[fd - ROMFS_FD_FIRST];
+}
+
+const void *
+romfs_map(const char *path, size_t *size)
+{
+  const struct romfs_entry *e;
+  const char *image;
+
+  if ((e = romfs_find(path, &image)) == NULL)
+  {
+    errno = ENOENT;
+    return NULL;
+  }
+
+  *size = e->size;
+  return image + e->offset;
+}
+
+int
+romfs_exists(const char *path)
+{
+  const char *image;
+
+  return romfs_find(path, &image) != NULL;
+}
+
+int
+romfs_isfd(int fd)
+{
+  return fd_lookup(fd) != NULL;
+}
+
+int
+romfs_open(struct _reent *reent, const char *path, int flags)
+{
+  const struct romfs_entry *e;
+  const char *image;
+  unsigned int fd;
+  int expected;
+
+  if ((e = romfs_find(path, &image)) == NULL)
+  {
+    __errno_r(reent) = ENOENT;
+    return -1;
+  }
+  if ((flags & O_ACCMODE) != O_RDONLY || (flags & O_TRUNC))
+  {
+    __errno_r(reent) = EROFS;
+    return -1;
+  }
+  if ((flags & O_CREAT) && (flags & O_EXCL))
+  {
+    __errno_r(reent) = EEXIST;
+    return -1;
+  }
+
+  for (fd = 0; fd < ROMFS_FDS; fd++)
+  {
+    expected = 0;
+#ifdef __riscv_atomic
+    if (__atomic_compare_exchange_n(&romfs_fds[fd].open, &expected, 1, 0,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+      break;
+#else
+    if (romfs_fds[fd].open == expected)
+    {
+      romfs_fds[fd].open = 1;
+      break;
+    }
+#endif
+  }
+  if (fd == ROMFS_FDS)
+  {
+    __errno_r(reent) = EMFILE;
+    return -1;
+  }
+
+  romfs_fds[fd].entry = e;
+  romfs_fds[fd].data = image + e->offset;
+  romfs_fds[fd].offset = 0;
+  return ROMFS_FD_FIRST + fd;
+}
+
+int
+romfs_close(struct _reent *reent, int fd)
+{
+  struct romfs_fd *d;
+
+  if ((d = fd_lookup(fd)) == NULL)
+  {
+    __errno_r(reent) = EBADF;
+    return -1;
+  }
+
+  __atomic_store_n(&d->open, 0, __ATOMIC_RELEASE);
+  return 0;
+}
+
+_ssize_t
+romfs_read(struct _reent *reent, int fd, void *buf, size_t len)
+{
+  struct romfs_fd *d;
+  size_t n;
+
+  if ((d = fd_lookup(fd)) == NULL)
+  {
+    __errno_r(reent) = EBADF;
+    return -1;
+  }
+
+  if ((size_t)d->offset >= d->entry->size)
+    return 0;
+
+  n = d->entry->size - d->offset;
+  if (n > len)
+    n = len;
+  memcpy(buf, d->data + d->offset, n);
+  d->offset += n;
+  return n;
+}
+
+_off_t
+romfs_lseek(struct _reent *reent, int fd, _off_t offset, int whence)
+{
+  struct romfs_fd *d;
+  _off_t base;
+
+  if ((d = fd_lookup(fd)) == NULL)
+  {
+    __errno_r(reent) = EBADF;
+    return -1;
+  }
+
+  switch (whence)
+  {
+    case SEEK_SET:
+      base = 0;
+      break;
+    case SEEK_CUR:
+      base = d->offset;
+      break;
+    case SEEK_END:
+      base = d->entry->size;
+      break;
+    default:
+      base = -1;
+      break;
+  }
+
+  if (base < 0 || base + offset < 0)
+  {
+    __errno_r(reent) = EINVAL;
+    return -1;
+  }
+
+  d->offset = base + offset;
+  return d->offset;
+}
+
+int
+romfs_fstat(struct _reent *reent, int fd, struct stat *st)
+{
+  struct romfs_fd *d;
+
+  if ((d = fd_lookup(fd)) == NULL)
+  {
+    __errno_r(reent) = EBADF;
+    return -1;
+  }
+
+  romfs_fill_stat(d->entry, st);
+  return 0;
+}
+
+int
+romfs_stat(struct _reent *reent, const char *path, struct stat *st)
+{
+  const struct romfs_entry *e;
+  const char *image;
+
+  if ((e = romfs_find(path, &image)) == NULL)
+  {
+    __errno_r(reent) = ENOENT;
+    return -1;
+  }
+
+  romfs_fill_stat(e, st);
+  return 0;
+}
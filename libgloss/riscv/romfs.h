@@ -0,0 +1,45 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * Read-only filesystem behind the file syscalls, see <machine/romfs.h>
+ * for the image format.
+ *
+ * Paths are looked up in the linked images first, with any leading '/'
+ * ignored; a path found there cannot be opened for writing, removed or
+ * renamed. Descriptors of ROM files follow those of the RAM filesystem.
+ * The functions follow the _*_r conventions of syscalls.c.
+ */
+
+#ifndef _RISCV_ROMFS_H
+#define _RISCV_ROMFS_H
+
+#include <reent.h>
+#include <sys/stat.h>
+#include <machine/romfs.h>
+#include "ramfs.h"
+
+#ifndef ROMFS_FDS
+#define ROMFS_FDS			8
+#endif
+
+/* st_blksize, and so the stdio buffer size, of ROM files */
+#ifndef ROMFS_BUFSIZE
+#define ROMFS_BUFSIZE		4096
+#endif
+
+#define ROMFS_FD_FIRST		(RAMFS_FD_FIRST + RAMFS_FDS)
+
+/* Nonzero if path names a ROM file */
+int romfs_exists(const char *path);
+
+/* Nonzero if fd is an open ROM file */
+int romfs_isfd(int fd);
+
+int romfs_open(struct _reent *reent, const char *path, int flags);
+int romfs_close(struct _reent *reent, int fd);
+_ssize_t romfs_read(struct _reent *reent, int fd, void *buf, size_t len);
+_off_t romfs_lseek(struct _reent *reent, int fd, _off_t offset, int whence);
+int romfs_fstat(struct _reent *reent, int fd, struct stat *st);
+int romfs_stat(struct _reent *reent, const char *path, struct stat *st);
+
+#endif /* _RISCV_ROMFS_H */
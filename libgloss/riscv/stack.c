@@ -0,0 +1,55 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * Stack high-water marks, see <machine/stack.h>.
+ */
+
+#include <stdint.h>
+#include <machine/hart.h>
+#include <machine/stack.h>
+#include "console.h"
+
+/* Defined by the linker script */
+extern char _stack_top[];
+extern char __stack_size[];
+extern char __stack_fill[];
+
+size_t
+stack_high_water_hart(unsigned long hart)
+{
+  size_t size = (size_t)__stack_size;
+  const uint32_t *p, *top;
+
+  if (!(uintptr_t)__stack_fill || hart >= hart_count())
+    return 0;
+
+  /* Stacks are carved downwards from _stack_top, see crt0 */
+  top = (const uint32_t *)(_stack_top - hart * size);
+  p = (const uint32_t *)((const char *)top - size);
+  while (p < top && *p == STACK_PATTERN)
+    p++;
+  return (const char *)top - (const char *)p;
+}
+
+size_t
+stack_high_water(void)
+{
+  return stack_high_water_hart(hart_id());
+}
+
+void
+stack_report(void)
+{
+  unsigned long hart;
+
+  for (hart = 0; hart < hart_count(); hart++)
+  {
+    console_puts("stack hart ");
+    console_putu(hart);
+    console_puts(": ");
+    console_putu(stack_high_water_hart(hart));
+    console_puts(" of ");
+    console_putu((size_t)__stack_size);
+    console_puts(" bytes\n");
+  }
+}
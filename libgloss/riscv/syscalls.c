@@ -1,356 +1,296 @@
 /**
  * Copyright (C) SoCHub Finland 2024
- * 
+ *
  * Authors:
  *  Andreas Stergiopoulos <andreas.stergiopoulos@tuni.fi>
  *  Väinö-Waltteri Granat <vaino-waltteri.granat@tuni.fi>
- * 
- * Non-reentrant syscalls for Headsail.
+ *
+ * Reentrant syscalls for Headsail.
+ *
+ * newlib is configured with REENTRANT_SYSCALLS_PROVIDED for this port,
+ * so the library calls these _*_r functions directly. Errors are stored
+ * in the errno of the struct _reent passed by the caller, which with
+ * several harts is the calling hart's own. Every call returns -1 on
+ * error, never a negative errno value. The POSIX names (write, read,
+ * ...) come from newlib's syscalls directory and forward here with
+ * _REENT.
  */
 
 #include <machine/syscall.h>
 #include <sys/types.h>
+#include <machine/uart.h>
+#include "hostio.h"
+#include "ramfs.h"
+#include "romfs.h"
 #include "uart8250.h"
+#ifdef USING_TRACE_BUFFER
+#include "tracebuf.h"
+#endif
+#include <reent.h>
 #include <unistd.h>
 #include <errno.h>
 #include <sys/stat.h>
 
-extern ssize_t _heap_start;
-extern ssize_t _heap_end;
-static caddr_t heap = NULL;
-
-// No reentrant versions of these exist
-void
-_exit(int exit_status)
-{
-  while (1);
-}
-
 int
-_kill(int pid, int sig)
+_kill_r(struct _reent *reent, int pid, int sig)
 {
-	return -1;
+  __errno_r(reent) = ENOSYS;
+  return -1;
 }
 
-
 /* Write to a file.  */
-ssize_t
-_write(int file, const void *ptr, size_t len)
+_ssize_t
+_write_r(struct _reent *reent, int file, const void *ptr, size_t len)
 {
-  /** We can only write to STDOUT. Files are not supported. */
-  if (file == STDOUT_FILENO)
-  {
+#ifdef USING_HOSTIO
+  /* The console and all files are the host's */
+  return hostio_write(reent, file, ptr, len);
+#else
 
+  /** STDOUT and STDERR go to the console, other descriptors are RAM files */
+  if (file == STDOUT_FILENO || file == STDERR_FILENO)
+  {
+#ifdef USING_TRACE_BUFFER
     /**
-     * Write len amount of bytes to the UART output buffer. This
-     * is a non-blocking write, which means that when writing
-     * consecutuvely, the CPU has to busy-wait for the transmission
-     * to finish before writing the next byte.
+     * Console output goes to the RAM trace buffer instead of the UART,
+     * costing no more than a memcpy.
      */
-    for(size_t i=0; i < len; i++)
-    {
-      uart8250_putc(((char*)ptr)[i]);
-    }
-
-    return (len);
+    return tracebuf_write((const char*)ptr, len);
+#else
+    /**
+     * Queue len amount of bytes for the UART. With the UART interrupt
+     * configured this only copies into the transmit ring; otherwise the
+     * driver fills the transmit FIFO in bursts, so the CPU only waits
+     * once per FIFO depth instead of once per byte.
+     */
+    return uart8250_enqueue((const char*)ptr, len);
+#endif
   }
-  else return -EBADF;
+
+  return ramfs_write(reent, file, ptr, len);
+#endif
+}
+
+int
+_close_r(struct _reent *reent, int fildes)
+{
+  /* The console descriptors are always open */
+  if (fildes >= 0 && fildes < 3)
+    return 0;
+
+  if (romfs_isfd(fildes))
+    return romfs_close(reent, fildes);
+#ifdef USING_HOSTIO
+  return hostio_close(reent, fildes);
+#else
+  return ramfs_close(reent, fildes);
+#endif
 }
 
 int
-_close(int fildes)
+_execve_r(struct _reent *reent, const char *name, char * const *argv,
+          char * const *env)
 {
-	return -1;
+  __errno_r(reent) = ENOSYS;
+  return -1;
 }
 
 int
-_execve(const char *name, char * const *argv,
-		char * const *env)
+_fcntl_r(struct _reent *reent, int fildes, int cmd, int arg)
 {
-	return -1;
+  __errno_r(reent) = ENOSYS;
+  return -1;
 }
 
 int
-_fork()
+_fork_r(struct _reent *reent)
 {
-	errno = ENOSYS;
-	return -1;
+  __errno_r(reent) = ENOSYS;
+  return -1;
 }
 
 int
-_fstat(int fildes, struct stat *st)
+_fstat_r(struct _reent *reent, int fildes, struct stat *st)
 {
-  if (fildes < 3)
+  if (fildes >= 0 && fildes < 3)
   {
     st->st_mode = S_IFCHR;
     st->st_blksize = 0;
     return 0;
   }
-	else return -1;
+
+  if (romfs_isfd(fildes))
+    return romfs_fstat(reent, fildes, st);
+#ifdef USING_HOSTIO
+  return hostio_fstat(reent, fildes, st);
+#else
+  return ramfs_fstat(reent, fildes, st);
+#endif
 }
 
 int
-_getpid()
+_getentropy_r(struct _reent *reent, void *buf, size_t buflen)
 {
-	return -1;
+  __errno_r(reent) = ENOSYS;
+  return -1;
 }
 
 int
-_isatty(int file)
+_getpid_r(struct _reent *reent)
 {
-	if (file < 3) return 1;
-  else return -1;
+  /* There is a single process */
+  return 1;
 }
 
 int
-_link(const char *existing, const char *new)
+_isatty_r(struct _reent *reent, int file)
 {
-	return -1;
+  if (file >= 0 && file < 3)
+    return 1;
+
+#ifdef USING_HOSTIO
+  if (!romfs_isfd(file))
+    return hostio_isatty(reent, file);
+  __errno_r(reent) = ENOTTY;
+#else
+  __errno_r(reent) = ramfs_isfd(file) || romfs_isfd(file) ? ENOTTY : EBADF;
+#endif
+  return 0;
+}
+
+int
+_link_r(struct _reent *reent, const char *existing, const char *new)
+{
+  __errno_r(reent) = ENOSYS;
+  return -1;
 }
 
 _off_t
-_lseek(int file, _off_t ptr, int dir)
+_lseek_r(struct _reent *reent, int file, _off_t ptr, int dir)
 {
-	errno = ENOSYS;
-	return -1;
+  /* The console cannot seek */
+  if (file >= 0 && file < 3)
+  {
+    __errno_r(reent) = ESPIPE;
+    return -1;
+  }
+
+  if (romfs_isfd(file))
+    return romfs_lseek(reent, file, ptr, dir);
+#ifdef USING_HOSTIO
+  return hostio_lseek(reent, file, ptr, dir);
+#else
+  return ramfs_lseek(reent, file, ptr, dir);
+#endif
+}
+
+int
+_mkdir_r(struct _reent *reent, const char *path, int mode)
+{
+  __errno_r(reent) = ENOSYS;
+  return -1;
 }
 
 int
-_open(const char *file, int flags, int mode)
+_open_r(struct _reent *reent, const char *file, int flags, int mode)
 {
-	return -1;
+  /* Files linked into the program shadow RAM files of the same name */
+  if (romfs_exists(file))
+    return romfs_open(reent, file, flags);
+#ifdef USING_HOSTIO
+  return hostio_open(reent, file, flags, mode);
+#else
+  return ramfs_open(reent, file, flags, mode);
+#endif
 }
 
 _ssize_t
-_read(int file, void *ptr, size_t len)
+_read_r(struct _reent *reent, int file, void *ptr, size_t len)
 {
+#ifdef USING_HOSTIO
+  if (romfs_isfd(file))
+    return romfs_read(reent, file, ptr, len);
+  return hostio_read(reent, file, ptr, len);
+#else
+
   /**
-   * There is no clear documentation on how read should work. However, 
-   * most places around the web and most importantly the linux man pages,
-   * agree that read should return exactly as many bytes as specified 
-   * in the len parameter, when reading from a file, unless there not 
-   * bytes left to read.
-   * 
-   * With regards to reading from stdin there is no clear documentation 
-   * for what is supposed to be done, so I will go with the version that 
-   * makes the most sense in this regard, which is that the syscall waits 
-   * for the user to press enter in order to stop reading characters from
-   * the console.
-   * 
-   * The return value for stdin will be a null terminated string.
+   * Reading from stdin follows the termios non-canonical rules rather
+   * than waiting for a full line: a read waits for VMIN bytes or for
+   * VTIME to expire, and returns whatever has been received so far, up
+   * to len bytes. The defaults (VMIN 1, VTIME 0) return as soon as at
+   * least one byte is available. See uart_rx_mode() in <machine/uart.h>.
+   *
+   * With the UART interrupt configured, input is collected into a ring
+   * buffer in the background, so bytes that arrive between reads are
+   * kept instead of overrunning the receive FIFO.
    */
   if (file == STDIN_FILENO)
   {
+    ssize_t bytes_read = uart8250_read((char*)ptr, len);
 
-    int bytes_read = 0;
-    char input;
-
-    for (int i = 0; i < len - 1; i++)
+    if (bytes_read < 0)
     {
-      input = uart8250_getc();
-      uart8250_putc(input);
-      ((char*)ptr)[i] = input;
-      bytes_read++;
-
-      if ((input == '\r') || (input == '\n')) break;
+      __errno_r(reent) = EAGAIN;
+      return -1;
     }
 
-    ((char*)ptr)[bytes_read] = '\0';
+    if (uart_rx_flags() & UART_RX_ECHO)
+      uart8250_enqueue((const char*)ptr, bytes_read);
 
     return bytes_read;
   }
+
+  if (romfs_isfd(file))
+    return romfs_read(reent, file, ptr, len);
+  return ramfs_read(reent, file, ptr, len);
+#endif
 }
 
 int
-_readlink(const char *path, char *buf, size_t bufsize)
+_rename_r(struct _reent *reent, const char *old, const char *new)
 {
-	return -1;
+  if (romfs_exists(old) || romfs_exists(new))
+  {
+    __errno_r(reent) = EROFS;
+    return -1;
+  }
+#ifdef USING_HOSTIO
+  return hostio_rename(reent, old, new);
+#else
+  return ramfs_rename(reent, old, new);
+#endif
 }
 
-caddr_t *
-_sbrk(ptrdiff_t incr)
+int
+_stat_r(struct _reent *reent, const char *path, struct stat *buf)
 {
-  caddr_t prevHeap;
-  caddr_t nextHeap;
-
-  if (heap == NULL) { // first allocation
-    heap = (caddr_t) & _heap_start;
-  }
-
-  prevHeap = heap;
-
-  // Always return data aligned on a 8 byte boundary
-  //nextHeap = (caddr_t) (((unsigned int) (heap + incr) + 7) & ~7); // Overflow?
-  nextHeap = (caddr_t) (((ssize_t) (heap + incr) + 7) & ~7); // Overflow?
-  if (nextHeap >= (caddr_t) & _heap_end) {
-    errno = ENOMEM;
-    return ((void*)-1); // error - no more memory
-  } else {
-    heap = nextHeap;
-    return (caddr_t) prevHeap;
-  }
+  if (romfs_exists(path))
+    return romfs_stat(reent, path, buf);
+#ifdef USING_HOSTIO
+  return hostio_stat(reent, path, buf);
+#else
+  return ramfs_stat(reent, path, buf);
+#endif
 }
 
 int
-_stat(const char *path, struct stat *buf)
+_unlink_r(struct _reent *reent, const char *path)
 {
-	return -1;
+  if (romfs_exists(path))
+  {
+    __errno_r(reent) = EROFS;
+    return -1;
+  }
+#ifdef USING_HOSTIO
+  return hostio_unlink(reent, path);
+#else
+  return ramfs_unlink(reent, path);
+#endif
 }
 
 int
-_unlink(const char * path)
+_wait_r(struct _reent *reent, int *status)
 {
-	return (-1);
+  __errno_r(reent) = ECHILD;
+  return -1;
 }
-
-/* /\* Write to a file.  *\/ */
-/* ssize_t */
-/* _write_r(struct _reent * reent, int file, const void *ptr, size_t len) */
-/* { */
-/*   /\** We can only write to STDOUT. Files are not supported. *\/ */
-/*   // if (file == STDOUT_FILENO) */
-/*   // { */
-
-/*     /\** */
-/*      * Write len amount of bytes to the UART output buffer. This */
-/*      * is a non-blocking write, which means that when writing */
-/*      * consecutuvely, the CPU has to busy-wait for the transmission */
-/*      * to finish before writing the next byte. */
-/*      *\/ */
-/*     for(size_t i=0; i < len; i++) */
-/*     { */
-/*       _uart8250_putc(((char*)ptr)[i]); */
-/*     } */
-
-/*     return (len); */
-/*   //} */
-/*   //else return syscall_errno(SYS_write, file, ptr, len, 0, 0, 0); */
-/* } */
-
-/* int */
-/* _close_r(struct _reent *reent, int fildes) */
-/* { */
-/* 	reent->_errno = ENOSYS; */
-/* 	return -1; */
-/* } */
-
-/* void */
-/* _exit_r(struct _reent *reent, int exit_status) */
-/* { */
-/* 	reent->_errno = ENOSYS; */
-/*   while (1); */
-/* } */
-
-/* int */
-/* _execve_r(struct _reent *reent, const char *name, char * const *argv, */
-/* 		char * const *env) */
-/* { */
-/* 	reent->_errno = ENOSYS; */
-/* 	return -1; */
-/* } */
-
-/* int */
-/* _fork_r(struct _reent *reent) */
-/* { */
-/* 	errno = ENOSYS; */
-/* 	return -1; */
-/* } */
-
-/* int */
-/* _fstat_r(struct _reent *reent, int fildes, struct stat *st) */
-/* { */
-/* 	reent->_errno = ENOSYS; */
-/* 	return -1; */
-/* } */
-
-/* int */
-/* _getpid_r(struct _reent *reent) */
-/* { */
-/* 	reent->_errno = ENOSYS; */
-/* 	return -1; */
-/* } */
-
-/* int */
-/* _isatty_r(struct _reent *reent, int file) */
-/* { */
-/* 	reent->_errno = ENOSYS; */
-/* 	return 0; */
-/* } */
-
-/* int */
-/* _kill_r(struct _reent *reent, int pid, int sig) */
-/* { */
-/* 	reent->_errno = ENOSYS; */
-/* 	return -1; */
-/* } */
-
-/* int */
-/* _link_r(struct _reent *reent, const char *existing, const char *new) */
-/* { */
-/* 	reent->_errno = ENOSYS; */
-/* 	return -1; */
-/* } */
-
-/* _off_t */
-/* _lseek_r(struct _reent *reent, int file, _off_t ptr, int dir) */
-/* { */
-/* 	errno = ENOSYS; */
-/* 	return -1; */
-/* } */
-
-/* int */
-/* _open_r(struct _reent *reent, const char *file, int flags, int mode) */
-/* { */
-/* 	reent->_errno = ENOSYS; */
-/* 	return -1; */
-/* } */
-
-/* _ssize_t */
-/* _read_r(struct _reent *reent, int file, void *ptr, size_t len) */
-/* { */
-/* 	reent->_errno = ENOSYS; */
-/* 	return -1; */
-/* } */
-
-/* int */
-/* _readlink_r(struct _reent *reent, const char *path, char *buf, size_t bufsize) */
-/* { */
-/* 	reent->_errno = ENOSYS; */
-/* 	return -1; */
-/* } */
-
-/* int */
-/* _stat_r(struct _reent *reent, const char *path, struct stat *buf) */
-/* { */
-/* 	reent->_errno = EIO; */
-/* 	return -1; */
-/* } */
-
-/* void * */
-/* _sbrk_r(struct _reent *reent, ptrdiff_t incr) */
-/* { */
-/*   static unsigned long heap_end; */
-
-/*   if (heap_end == 0) */
-/*     { */
-/*       long brk = __internal_syscall (SYS_brk, 0, 0, 0, 0, 0, 0); */
-/*       if (brk == -1) */
-/*         reent->_errno = -ENOMEM; */
-/*         return (void *)__syscall_error (-ENOMEM); */
-/*       heap_end = brk; */
-/*     } */
-
-/*   if (__internal_syscall (SYS_brk, heap_end + incr, 0, 0, 0, 0, 0) != heap_end + incr) */
-/*     reent->_errno = -ENOMEM; */
-/*     return (void *)__syscall_error (-ENOMEM); */
-
-/*   heap_end += incr; */
-/*   return (void *)(heap_end - incr); */
-/* } */
-
-/* int */
-/* _unlink_r(struct _reent *reent, const char * path) */
-/* { */
-/* 	reent->_errno = EIO; */
-/* 	return (-1); */
-/* } */
@@ -0,0 +1,167 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * Clocks for Headsail, built on the time and cycle CSRs.
+ *
+ * CLOCK_MONOTONIC counts the real-time counter (time CSR) from reset.
+ * CLOCK_REALTIME is the same counter plus an offset set with
+ * clock_settime() or settimeofday(); it starts at the epoch, as the
+ * board has no battery-backed clock. CLOCK_PROCESS_CPUTIME_ID counts the
+ * cycles of the calling hart. The counter frequencies are the board's
+ * timebase_freq and cpu_freq, see <machine/cycles.h>.
+ *
+ * times() reports the hart's cycles as user time, so clock() measures
+ * processor time, and returns the real-time counter as elapsed time,
+ * both in CLOCKS_PER_SEC units.
+ */
+
+#include <machine/cycles.h>
+#include <reent.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/times.h>
+#include "encoding.h"
+
+#define NSEC_PER_SEC	1000000000ULL
+
+/* CLOCK_REALTIME at the moment the time counter was zero */
+static struct timespec realtime_base;
+static int realtime_lock_word;
+
+static void
+ticks_to_timespec(uint64_t ticks, unsigned long freq, struct timespec *tp)
+{
+  tp->tv_sec = ticks / freq;
+  tp->tv_nsec = (ticks % freq) * NSEC_PER_SEC / freq;
+}
+
+static clock_t
+ticks_to_clock(uint64_t ticks, unsigned long freq)
+{
+  return (clock_t) ((ticks / freq) * CLOCKS_PER_SEC
+		    + (ticks % freq) * CLOCKS_PER_SEC / freq);
+}
+
+static void
+realtime(struct timespec *tp)
+{
+  struct timespec base;
+
+  spin_lock(&realtime_lock_word);
+  base = realtime_base;
+  spin_unlock(&realtime_lock_word);
+
+  ticks_to_timespec(timebase_read(), timebase_freq, tp);
+  tp->tv_sec += base.tv_sec;
+  tp->tv_nsec += base.tv_nsec;
+  if (tp->tv_nsec >= (long) NSEC_PER_SEC)
+  {
+    tp->tv_sec++;
+    tp->tv_nsec -= NSEC_PER_SEC;
+  }
+}
+
+int
+clock_gettime(clockid_t clock_id, struct timespec *tp)
+{
+  switch (clock_id)
+  {
+  case CLOCK_REALTIME:
+    realtime(tp);
+    return 0;
+  case CLOCK_MONOTONIC:
+    ticks_to_timespec(timebase_read(), timebase_freq, tp);
+    return 0;
+  case CLOCK_PROCESS_CPUTIME_ID:
+    ticks_to_timespec(cycles_read(), cpu_freq, tp);
+    return 0;
+  default:
+    errno = EINVAL;
+    return -1;
+  }
+}
+
+int
+clock_getres(clockid_t clock_id, struct timespec *res)
+{
+  unsigned long freq;
+
+  switch (clock_id)
+  {
+  case CLOCK_REALTIME:
+  case CLOCK_MONOTONIC:
+    freq = timebase_freq;
+    break;
+  case CLOCK_PROCESS_CPUTIME_ID:
+    freq = cpu_freq;
+    break;
+  default:
+    errno = EINVAL;
+    return -1;
+  }
+
+  if (res != NULL)
+  {
+    res->tv_sec = 0;
+    res->tv_nsec = (NSEC_PER_SEC + freq - 1) / freq;
+  }
+  return 0;
+}
+
+int
+clock_settime(clockid_t clock_id, const struct timespec *tp)
+{
+  struct timespec now;
+
+  if (clock_id != CLOCK_REALTIME)
+  {
+    errno = EINVAL;
+    return -1;
+  }
+  if (tp->tv_nsec < 0 || tp->tv_nsec >= (long) NSEC_PER_SEC)
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  ticks_to_timespec(timebase_read(), timebase_freq, &now);
+  now.tv_sec = tp->tv_sec - now.tv_sec;
+  now.tv_nsec = tp->tv_nsec - now.tv_nsec;
+  if (now.tv_nsec < 0)
+  {
+    now.tv_sec--;
+    now.tv_nsec += NSEC_PER_SEC;
+  }
+
+  /* Other harts read the base in realtime() */
+  spin_lock(&realtime_lock_word);
+  realtime_base = now;
+  spin_unlock(&realtime_lock_word);
+  return 0;
+}
+
+int
+_gettimeofday_r(struct _reent *reent, struct timeval *tv, void *tz)
+{
+  struct timespec now;
+
+  if (tv != NULL)
+  {
+    realtime(&now);
+    tv->tv_sec = now.tv_sec;
+    tv->tv_usec = now.tv_nsec / 1000;
+  }
+  return 0;
+}
+
+clock_t
+_times_r(struct _reent *reent, struct tms *buf)
+{
+  buf->tms_utime = ticks_to_clock(cycles_read(), cpu_freq);
+  buf->tms_stime = 0;
+  buf->tms_cutime = 0;
+  buf->tms_cstime = 0;
+
+  return ticks_to_clock(timebase_read(), timebase_freq);
+}
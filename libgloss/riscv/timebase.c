@@ -0,0 +1,13 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * Default counter frequencies for Headsail, see <machine/cycles.h>.
+ */
+
+#include <machine/cycles.h>
+
+__attribute__((weak))
+const unsigned long timebase_freq = 1000000;
+
+__attribute__((weak))
+const unsigned long cpu_freq = 1000000;
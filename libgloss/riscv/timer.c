@@ -0,0 +1,78 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * Per-hart machine timer multiplexing, see timer.h.
+ */
+
+#include <machine/cycles.h>
+#include "clint.h"
+#include "encoding.h"
+#include "timer.h"
+
+struct hart_timer
+{
+  uint64_t wakeup;		/* Sleep deadline, UINT64_MAX if none */
+  uint64_t next_tick;		/* Time of the next tick */
+  uint64_t period;		/* Tick period, 0 if no tick */
+  void (*fn)(uintptr_t pc);	/* Tick handler */
+};
+
+static __thread struct hart_timer timer = { UINT64_MAX, UINT64_MAX, 0, 0 };
+
+/* Program mtimecmp with the earliest armed event, interrupts masked */
+static void
+timer_program(void)
+{
+  uint64_t when = timer.wakeup;
+
+  if (timer.period != 0 && timer.next_tick < when)
+    when = timer.next_tick;
+
+  clint_set_timer(read_csr(mhartid), when);
+  if (when == UINT64_MAX)
+    clear_csr(mie, MIP_MTIP);
+  else
+    set_csr(mie, MIP_MTIP);
+}
+
+void
+timer_wakeup_at(uint64_t when)
+{
+  unsigned long flags = irq_save();
+
+  timer.wakeup = when;
+  timer_program();
+  irq_restore(flags);
+}
+
+void
+timer_tick(uint64_t period, void (*fn)(uintptr_t pc))
+{
+  unsigned long flags = irq_save();
+
+  timer.period = fn != 0 ? period : 0;
+  timer.fn = fn;
+  timer.next_tick = timebase_read() + period;
+  timer_program();
+  irq_restore(flags);
+}
+
+void
+timer_isr(unsigned long cause, uintptr_t mepc)
+{
+  uint64_t now = timebase_read();
+
+  if (now >= timer.wakeup)
+    timer.wakeup = UINT64_MAX;
+
+  if (timer.period != 0 && now >= timer.next_tick)
+  {
+    timer.fn(mepc);
+    timer.next_tick += timer.period;
+    /* Drop ticks missed while interrupts were masked */
+    if (timer.next_tick <= now)
+      timer.next_tick = now + timer.period;
+  }
+
+  timer_program();
+}
@@ -0,0 +1,31 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * Per-hart machine timer shared by the sleep functions and the profiler.
+ *
+ * Each hart has one mtimecmp register. A hart may at the same time be
+ * sleeping until a deadline and have a periodic tick running (the
+ * profiler), so the compare register is always programmed with the
+ * earlier of the two, and the timer interrupt is enabled in mie only
+ * while one of them is armed. The state is thread-local, so every hart
+ * manages its own timer without locking.
+ */
+
+#ifndef _RISCV_TIMER_H
+#define _RISCV_TIMER_H
+
+#include <stdint.h>
+
+/* Arm the wakeup deadline of the calling hart, UINT64_MAX disarms it.
+   The timer interrupt is raised once the time CSR reaches when; the
+   deadline is then disarmed, the caller polls the time itself.  */
+void timer_wakeup_at(uint64_t when);
+
+/* Call fn with the interrupted pc every period time ticks on the calling
+   hart, from the timer interrupt. A period of 0 stops the tick.  */
+void timer_tick(uint64_t period, void (*fn)(uintptr_t pc));
+
+/* Timer interrupt handler, the default trap handler of IRQ_M_TIMER.  */
+void timer_isr(unsigned long cause, uintptr_t mepc);
+
+#endif /* _RISCV_TIMER_H */
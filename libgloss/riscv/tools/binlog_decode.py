@@ -0,0 +1,219 @@
+#!/usr/bin/env python3
+# Copyright (C) SoCHub Finland 2024
+#
+# This copyrighted material is made available to anyone wishing to use,
+# modify, copy, or redistribute it subject to the terms and conditions
+# of the FreeBSD License.   This program is distributed in the hope that
+# it will be useful, but WITHOUT ANY WARRANTY expressed or implied,
+# including the implied warranties of MERCHANTABILITY or FITNESS FOR
+# A PARTICULAR PURPOSE.  A copy of this license is available at
+# http://www.opensource.org/licenses.
+
+"""Decode binlog records from a console capture.
+
+Usage: binlog_decode.py program.elf [capture]
+
+Reads the console byte stream from the capture file (or stdin, e.g. a
+serial port piped through cat), passes ordinary text through and replaces
+every binlog record with its formatted text, using the format strings
+stored in the binlog_fmt section of the ELF file.  See
+<machine/binlog.h> for the record format.
+"""
+
+import re
+import struct
+import sys
+
+BINLOG_SYNC = 0x1E
+FMT_SECTION = "binlog_fmt"
+SHT_NOBITS = 8
+SHF_ALLOC = 0x2
+
+CONVERSION = re.compile(
+    rb"%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d*))?(hh|h|ll|l|j|z|t|L)?([diouxXeEfFgGaAcspn%])")
+
+
+class Elf:
+    """Just enough of an ELF reader to find sections by name or address."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF":
+            raise ValueError("%s is not an ELF file" % path)
+        self.is64 = self.data[4] == 2
+        self.endian = "<" if self.data[5] == 1 else ">"
+        if self.is64:
+            shoff, = struct.unpack_from(self.endian + "Q", self.data, 0x28)
+            shentsize, shnum, shstrndx = struct.unpack_from(
+                self.endian + "HHH", self.data, 0x3A)
+            fmt = "IIQQQQIIQQ"
+        else:
+            shoff, = struct.unpack_from(self.endian + "I", self.data, 0x20)
+            shentsize, shnum, shstrndx = struct.unpack_from(
+                self.endian + "HHH", self.data, 0x2E)
+            fmt = "IIIIIIIIII"
+        self.sections = []
+        for i in range(shnum):
+            (name, stype, flags, addr, offset, size, _, _, _, _) = \
+                struct.unpack_from(self.endian + fmt, self.data,
+                                   shoff + i * shentsize)
+            self.sections.append([name, stype, flags, addr, offset, size])
+        strtab = self.sections[shstrndx]
+        for s in self.sections:
+            s[0] = self._cstring(strtab[4] + s[0])
+
+    def _cstring(self, offset):
+        end = self.data.index(b"\0", offset)
+        return self.data[offset:end]
+
+    def section(self, name):
+        for s in self.sections:
+            if s[0] == name.encode():
+                return s
+        return None
+
+    def string_at(self, addr):
+        """NUL-terminated string at a target address, or None."""
+        for name, stype, flags, base, offset, size in self.sections:
+            if (flags & SHF_ALLOC and stype != SHT_NOBITS
+                    and base <= addr < base + size):
+                return self._cstring(offset + addr - base)
+        return None
+
+
+def uleb128(buf, pos):
+    value = shift = 0
+    while True:
+        b = buf[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        shift += 7
+        if not b & 0x80:
+            return value, pos
+
+
+def unzigzag(v):
+    return (v >> 1) ^ -(v & 1)
+
+
+class Decoder:
+    def __init__(self, elf, xlen):
+        self.elf = elf
+        self.xlen = xlen
+        sec = elf.section(FMT_SECTION)
+        if sec is None:
+            raise ValueError("no %s section, program does not use binlog"
+                             % FMT_SECTION)
+        self.fmt_base = sec[4]
+        self.fmt_size = sec[5]
+
+    def format(self, fmt_id, args):
+        if fmt_id == 0:
+            if args and args[0] != self.fmt_size:
+                return b"[binlog: ELF file does not match the target]\n"
+            return b""
+        fmt = self.elf._cstring(self.fmt_base + fmt_id - 1)
+        args = list(args)
+        out = []
+        pos = 0
+        for m in CONVERSION.finditer(fmt):
+            out.append(fmt[pos:m.start()])
+            pos = m.end()
+            flags, width, prec, length, conv = m.groups()
+            if conv == b"%":
+                out.append(b"%")
+                continue
+            if width == b"*":
+                width = str(args.pop(0) if args else 0).encode()
+            if prec == b"*":
+                prec = str(args.pop(0) if args else 0).encode()
+            if not args:
+                out.append(b"<?>")
+                continue
+            out.append(self.convert(flags, width, prec, length, conv,
+                                    args.pop(0)))
+        out.append(fmt[pos:])
+        return b"".join(out)
+
+    def convert(self, flags, width, prec, length, conv, v):
+        spec = b"%" + flags + (width or b"")
+        if prec is not None:
+            spec += b"." + prec
+        if conv in b"eEfFgGaA":
+            d, = struct.unpack("<d", struct.pack("<q", v))
+            if conv in b"aA":
+                text = d.hex().encode()
+                return text.upper() if conv == b"A" else text
+            return (spec + conv) % d
+        if conv == b"s":
+            s = self.elf.string_at(v & ((1 << self.xlen) - 1))
+            if s is None:
+                s = b"<0x%x>" % (v & ((1 << self.xlen) - 1))
+            return (spec + b"s") % s
+        if conv == b"c":
+            return (spec + b"c") % (v & 0xFF)
+        if conv == b"p":
+            return b"0x%x" % (v & ((1 << self.xlen) - 1))
+        if conv == b"n":
+            return b""
+        bits = {b"hh": 8, b"h": 16, b"l": self.xlen, b"ll": 64, b"j": 64,
+                b"z": self.xlen, b"t": self.xlen}.get(length, 32)
+        v &= (1 << bits) - 1
+        if conv in b"di":
+            if v >> (bits - 1):
+                v -= 1 << bits
+            conv = b"d"
+        return (spec + conv) % v
+
+    def run(self, stream, out):
+        buf = b""
+        while True:
+            chunk = stream.read1(4096) if hasattr(stream, "read1") \
+                else stream.read(4096)
+            if not chunk:
+                break
+            buf += chunk
+            while buf:
+                sync = buf.find(bytes([BINLOG_SYNC]))
+                if sync < 0:
+                    out.write(buf)
+                    buf = b""
+                    break
+                out.write(buf[:sync])
+                buf = buf[sync:]
+                if len(buf) < 2 or len(buf) < 2 + buf[1]:
+                    break
+                payload = buf[2:2 + buf[1]]
+                buf = buf[2 + buf[1]:]
+                values = []
+                pos = 0
+                while pos < len(payload):
+                    v, pos = uleb128(payload, pos)
+                    values.append(v)
+                if values:
+                    out.write(self.format(values[0],
+                                          [unzigzag(v) for v in values[1:]]))
+            out.flush()
+        out.write(buf)
+        out.flush()
+
+
+def main(argv):
+    args = [a for a in argv[1:] if not a.startswith("--xlen=")]
+    xlen = 64
+    for a in argv[1:]:
+        if a.startswith("--xlen="):
+            xlen = int(a[len("--xlen="):])
+    if not args or len(args) > 2:
+        sys.stderr.write("usage: %s [--xlen=32|64] program.elf [capture]\n"
+                         % argv[0])
+        return 2
+    decoder = Decoder(Elf(args[0]), xlen)
+    stream = open(args[1], "rb") if len(args) > 1 else sys.stdin.buffer
+    decoder.run(stream, sys.stdout.buffer)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,251 @@
+#!/usr/bin/env python3
+# Copyright (C) SoCHub Finland 2024
+#
+# This copyrighted material is made available to anyone wishing to use,
+# modify, copy, or redistribute it subject to the terms and conditions
+# of the FreeBSD License.   This program is distributed in the hope that
+# it will be useful, but WITHOUT ANY WARRANTY expressed or implied,
+# including the implied warranties of MERCHANTABILITY or FITNESS FOR
+# A PARTICULAR PURPOSE.  A copy of this license is available at
+# http://www.opensource.org/licenses.
+
+"""Analyse function traces recorded with -finstrument-functions.
+
+Usage: functrace.py program.elf capture [--folded FILE] [--top N]
+       functrace.py program.elf --memory functrace.bin [...]
+
+The trace is read from a console capture holding the dumps written at
+exit, or with --memory from a binary image of __functrace saved by a
+debugger:
+
+  (gdb) dump binary value functrace.bin __functrace
+
+See <machine/functrace.h> for the record format.  The tool prints a
+latency table and histogram per function, with cycle counts, and the N
+slowest calls with their call stacks.  --folded writes self cycles per
+call stack in the folded format read by flamegraph.pl and speedscope.
+"""
+
+import os
+import re
+import struct
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from binlog_decode import Elf, uleb128, unzigzag  # noqa: E402
+
+FUNCTRACE_MAGIC = 0x43525446
+STT_FUNC = 2
+
+BEGIN = re.compile(rb"^--- functrace hart (\d+) start (\d+) dropped (\d+)"
+                   rb" bytes (\d+) ---$")
+END = b"--- end functrace ---"
+
+
+def symbols(elf):
+    """Map function start addresses to names."""
+    names = {}
+    symtab = elf.section(".symtab")
+    strtab = elf.section(".strtab")
+    if symtab is None or strtab is None:
+        return names
+    fmt = elf.endian + ("IBBHQQ" if elf.is64 else "IIIBBH")
+    for pos in range(symtab[4], symtab[4] + symtab[5], struct.calcsize(fmt)):
+        if elf.is64:
+            st_name, info, _, _, value, _ = struct.unpack_from(
+                fmt, elf.data, pos)
+        else:
+            st_name, value, _, info, _, _ = struct.unpack_from(
+                fmt, elf.data, pos)
+        if info & 0xF == STT_FUNC and value:
+            names.setdefault(value,
+                             elf._cstring(strtab[4] + st_name).decode())
+    return names
+
+
+def records(data, start):
+    """Yield (fn, is_exit, cycle) from one hart's byte stream."""
+    pos = 0
+    fn = 0
+    cycle = start
+    while pos < len(data):
+        v, pos = uleb128(data, pos)
+        fn += unzigzag(v >> 1)
+        delta, pos = uleb128(data, pos)
+        cycle += delta
+        yield fn, v & 1, cycle
+
+
+def from_console(stream):
+    """Trace buffers per hart from a console capture."""
+    harts = {}
+    cur = None
+    for line in stream:
+        line = line.strip()
+        m = BEGIN.match(line)
+        if m:
+            cur = (int(m.group(1)), int(m.group(2)), int(m.group(3)),
+                   int(m.group(4)), bytearray())
+        elif cur is None:
+            continue
+        elif line == END:
+            hart, start, dropped, size, data = cur
+            if len(data) == size:
+                harts[hart] = (start, dropped, bytes(data))
+            cur = None
+        else:
+            try:
+                cur[4].extend(bytes.fromhex(line.decode("ascii")))
+            except ValueError:
+                continue
+    return harts
+
+
+def from_memory(elf, image):
+    """Trace buffers per hart from a binary image of __functrace."""
+    harts = {}
+    header = 32 + (8 if elf.is64 else 4)
+    stride = None
+    # The buffer size is not in the ELF, take it from a used buffer
+    pos = 0
+    while stride is None and pos + header <= len(image):
+        magic, size = struct.unpack_from(elf.endian + "II", image, pos)
+        if magic == FUNCTRACE_MAGIC:
+            stride = (header + size + 7) & ~7
+        pos += 8
+    if stride is None:
+        return harts
+    for hart in range(len(image) // stride):
+        pos = hart * stride
+        magic, size, used, dropped, start = struct.unpack_from(
+            elf.endian + "IIIIQ", image, pos)
+        if magic == FUNCTRACE_MAGIC:
+            harts[hart] = (start, dropped,
+                           image[pos + header:pos + header + used])
+    return harts
+
+
+class Call:
+    __slots__ = ("fn", "start", "child")
+
+    def __init__(self, fn, start):
+        self.fn = fn
+        self.start = start
+        self.child = 0
+
+
+def analyse(harts, name):
+    folded = {}
+    latency = {}
+    slowest = []
+    for hart, (start, dropped, data) in sorted(harts.items()):
+        stack = []
+        for fn, is_exit, cycle in records(data, start):
+            if not is_exit:
+                stack.append(Call(fn, cycle))
+                continue
+            # Unwind calls left by longjmp or lost records
+            while stack and stack[-1].fn != fn:
+                stack.pop()
+            if not stack:
+                continue
+            call = stack.pop()
+            total = cycle - call.start
+            path = ";".join(name(c.fn) for c in stack + [call])
+            folded[path] = folded.get(path, 0) + total - call.child
+            latency.setdefault(call.fn, []).append(total)
+            slowest.append((total, hart, path))
+            if stack:
+                stack[-1].child += total
+        if dropped:
+            sys.stderr.write("hart %d: %d records dropped, buffer full\n"
+                             % (hart, dropped))
+    return folded, latency, slowest
+
+
+def percentile(sorted_values, p):
+    return sorted_values[min(len(sorted_values) - 1,
+                             int(len(sorted_values) * p / 100))]
+
+
+def print_latency(latency, name, out):
+    out.write("%-32s %8s %10s %10s %10s %10s %10s\n"
+              % ("function", "calls", "min", "p50", "p90", "p99", "max"))
+    rows = sorted(latency.items(), key=lambda kv: -sum(kv[1]))
+    for fn, values in rows:
+        values.sort()
+        out.write("%-32s %8d %10d %10d %10d %10d %10d\n"
+                  % (name(fn)[:32], len(values), values[0],
+                     percentile(values, 50), percentile(values, 90),
+                     percentile(values, 99), values[-1]))
+    for fn, values in rows:
+        out.write("\n%s, cycles per call:\n" % name(fn))
+        buckets = {}
+        for v in values:
+            buckets[v.bit_length()] = buckets.get(v.bit_length(), 0) + 1
+        peak = max(buckets.values())
+        for b in range(min(buckets), max(buckets) + 1):
+            n = buckets.get(b, 0)
+            lo = 0 if b == 0 else 1 << (b - 1)
+            line = "  %10d .. %-10d %8d %s" % (lo, (1 << b) - 1, n,
+                                               "#" * (n * 50 // peak))
+            out.write(line.rstrip() + "\n")
+
+
+def main(argv):
+    args = argv[1:]
+    folded_file = None
+    top = 10
+    memory = None
+    for opt in ("--folded", "--top", "--memory"):
+        if opt in args:
+            i = args.index(opt)
+            if i + 1 >= len(args):
+                args = []
+                break
+            value = args[i + 1]
+            del args[i:i + 2]
+            if opt == "--folded":
+                folded_file = value
+            elif opt == "--top":
+                top = int(value)
+            else:
+                memory = value
+    if not args or len(args) > 2 or (memory and len(args) > 1):
+        sys.stderr.write(__doc__)
+        return 2
+
+    elf = Elf(args[0])
+    names = symbols(elf)
+
+    def name(fn):
+        return names.get(fn, "0x%x" % fn)
+
+    if memory:
+        with open(memory, "rb") as f:
+            harts = from_memory(elf, f.read())
+    else:
+        stream = open(args[1], "rb") if len(args) > 1 else sys.stdin.buffer
+        harts = from_console(stream)
+    if not harts:
+        sys.stderr.write("no function trace found\n")
+        return 1
+
+    folded, latency, slowest = analyse(harts, name)
+    print_latency(latency, name, sys.stdout)
+
+    if top:
+        sys.stdout.write("\nslowest calls:\n")
+        for total, hart, path in sorted(slowest, reverse=True)[:top]:
+            sys.stdout.write("  %10d  hart %d  %s\n" % (total, hart, path))
+
+    if folded_file:
+        with open(folded_file, "w") as f:
+            for path, cycles in sorted(folded.items()):
+                if cycles > 0:
+                    f.write("%s %d\n" % (path, cycles))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+# Copyright (C) SoCHub Finland 2024
+#
+# This copyrighted material is made available to anyone wishing to use,
+# modify, copy, or redistribute it subject to the terms and conditions
+# of the FreeBSD License.   This program is distributed in the hope that
+# it will be useful, but WITHOUT ANY WARRANTY expressed or implied,
+# including the implied warranties of MERCHANTABILITY or FITNESS FOR
+# A PARTICULAR PURPOSE.  A copy of this license is available at
+# http://www.opensource.org/licenses.
+
+"""Extract gmon.out from a console capture.
+
+Usage: gmon_extract.py [capture] [-o gmon.out]
+
+Finds the hex dump that the profiler writes to the console at exit
+(see <machine/gmon.h>) in the capture file or stdin, and writes the
+binary profile for gprof.  If the capture holds several dumps, the
+last complete one is used.
+"""
+
+import re
+import sys
+
+BEGIN = re.compile(rb"^--- gmon\.out (\d+) bytes ---$")
+END = b"--- end gmon.out ---"
+
+
+def extract(lines):
+    image = None
+    data = None
+    size = 0
+    for line in lines:
+        line = line.strip()
+        m = BEGIN.match(line)
+        if m:
+            data = bytearray()
+            size = int(m.group(1))
+        elif data is None:
+            continue
+        elif line == END:
+            if len(data) == size:
+                image = bytes(data)
+            data = None
+        else:
+            try:
+                data += bytes.fromhex(line.decode("ascii"))
+            except ValueError:
+                # Other console output interleaved with the dump
+                continue
+    return image
+
+
+def main(argv):
+    args = argv[1:]
+    out = "gmon.out"
+    if "-o" in args:
+        i = args.index("-o")
+        if i + 1 >= len(args):
+            sys.stderr.write("usage: %s [capture] [-o gmon.out]\n" % argv[0])
+            return 2
+        out = args[i + 1]
+        del args[i:i + 2]
+    if len(args) > 1:
+        sys.stderr.write("usage: %s [capture] [-o gmon.out]\n" % argv[0])
+        return 2
+    stream = open(args[0], "rb") if args else sys.stdin.buffer
+    image = extract(stream)
+    if image is None:
+        sys.stderr.write("no complete gmon.out dump found\n")
+        return 1
+    with open(out, "wb") as f:
+        f.write(image)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,227 @@
+#!/usr/bin/env python3
+# Copyright (C) SoCHub Finland 2024
+#
+# This copyrighted material is made available to anyone wishing to use,
+# modify, copy, or redistribute it subject to the terms and conditions
+# of the FreeBSD License.   This program is distributed in the hope that
+# it will be useful, but WITHOUT ANY WARRANTY expressed or implied,
+# including the implied warranties of MERCHANTABILITY or FITNESS FOR
+# A PARTICULAR PURPOSE.  A copy of this license is available at
+# http://www.opensource.org/licenses.
+
+"""Compress the .data image of a linked program with LZ4.
+
+Usage: lz4data.py [-o output.elf] program.elf
+
+The program must be linked with headsail.ld and a separate load address
+for .data (__data_load_addr), so that the image at _data_load is only
+the source of the copy made by crt0.  The image is replaced by an LZ4
+block, and its program header and the .data and .sdata section headers
+are shrunk to the compressed size, so that loaders going by segments and
+by sections (GDB load) transfer fewer bytes.  The section headers then
+no longer cover the variables, which debuggers read from the target
+anyway.  __data_lz4_size tells crt0 to expand the image instead of
+copying it.  Without -o the program is rewritten in place:
+
+  riscv64-unknown-elf-gcc ... -Wl,--defsym=__data_load_addr=0x... \\
+      -T headsail.ld -o prog.elf
+  lz4data.py prog.elf
+"""
+
+import struct
+import sys
+
+PT_LOAD = 1
+SHT_SYMTAB = 2
+SHT_NOBITS = 8
+MIN_MATCH = 4
+LAST_LITERALS = 5       # The block ends with at least 5 literals
+MATCH_LIMIT = 12        # and no match starts in its last 12 bytes
+MAX_OFFSET = 0xFFFF
+
+
+def lz4_length(out, n):
+    while n >= 255:
+        out.append(255)
+        n -= 255
+    out.append(n)
+
+
+def lz4_compress(src):
+    """Greedy LZ4 block compression with a hash of 4-byte sequences."""
+    n = len(src)
+    out = bytearray()
+    table = {}
+    anchor = 0
+    i = 0
+    while i + MATCH_LIMIT <= n:
+        key = src[i:i + MIN_MATCH]
+        ref = table.get(key)
+        table[key] = i
+        if ref is None or i - ref > MAX_OFFSET:
+            i += 1
+            continue
+        length = MIN_MATCH
+        limit = n - LAST_LITERALS
+        while i + length < limit and src[ref + length] == src[i + length]:
+            length += 1
+
+        literals = i - anchor
+        ml = length - MIN_MATCH
+        out.append((min(literals, 15) << 4) | min(ml, 15))
+        if literals >= 15:
+            lz4_length(out, literals - 15)
+        out += src[anchor:i]
+        out += struct.pack("<H", i - ref)
+        if ml >= 15:
+            lz4_length(out, ml - 15)
+
+        for j in range(i + 1, min(i + length, n - MIN_MATCH)):
+            table[src[j:j + MIN_MATCH]] = j
+        i += length
+        anchor = i
+
+    literals = n - anchor
+    out.append(min(literals, 15) << 4)
+    if literals >= 15:
+        lz4_length(out, literals - 15)
+    out += src[anchor:]
+    return bytes(out)
+
+
+class Elf:
+    def __init__(self, data):
+        if data[:4] != b"\x7fELF" or data[5] != 1:
+            raise ValueError("not a little-endian ELF file")
+        self.data = data
+        self.is64 = data[4] == 2
+        if self.is64:
+            hdr = struct.unpack_from("<QQQIHHHHHH", data, 24)
+            self.phdr = struct.Struct("<IIQQQQQQ")
+            self.shdr = struct.Struct("<IIQQQQIIQQ")
+            self.sym = struct.Struct("<IBBHQQ")
+        else:
+            hdr = struct.unpack_from("<IIIIHHHHHH", data, 24)
+            self.phdr = struct.Struct("<IIIIIIII")
+            self.shdr = struct.Struct("<IIIIIIIIII")
+            self.sym = struct.Struct("<IIIBBH")
+        _, self.phoff, self.shoff, _, _, _, self.phnum, _, self.shnum, _ = hdr
+
+    def segments(self):
+        for i in range(self.phnum):
+            off = self.phoff + i * self.phdr.size
+            f = self.phdr.unpack_from(self.data, off)
+            if self.is64:
+                ptype, _, offset, vaddr, paddr, filesz, memsz, _ = f
+            else:
+                ptype, offset, vaddr, paddr, filesz, memsz, _, _ = f
+            yield off, ptype, offset, vaddr, paddr, filesz, memsz
+
+    def sections(self):
+        for i in range(self.shnum):
+            f = self.shdr.unpack_from(self.data, self.shoff + i * self.shdr.size)
+            # type, addr, offset, size, link, entsize
+            yield f[1], f[3], f[4], f[5], f[6], f[9]
+
+    def shrink_sections(self, start, end, limit):
+        """Cut the sections in file range start..end back to limit."""
+        for i, (stype, _, offset, size, _, _) in enumerate(self.sections()):
+            if stype == SHT_NOBITS or not start <= offset < end:
+                continue
+            size = max(0, min(size, limit - offset))
+            pos = self.shoff + i * self.shdr.size
+            if self.is64:
+                struct.pack_into("<Q", self.data, pos + 32, size)
+            else:
+                struct.pack_into("<I", self.data, pos + 20, size)
+
+    def symbols(self):
+        sections = list(self.sections())
+        syms = {}
+        for stype, _, offset, size, link, entsize in sections:
+            if stype != SHT_SYMTAB:
+                continue
+            stroff = sections[link][2]
+            for pos in range(offset, offset + size, entsize):
+                f = self.sym.unpack_from(self.data, pos)
+                name, value = f[0], f[4] if self.is64 else f[1]
+                end = self.data.index(b"\0", stroff + name)
+                syms[self.data[stroff + name:end].decode()] = value
+        return syms
+
+    def file_offset(self, addr):
+        for stype, saddr, offset, size, _, _ in self.sections():
+            if stype != SHT_NOBITS and saddr and saddr <= addr < saddr + size:
+                return offset + addr - saddr
+        return None
+
+
+def main(argv):
+    args = argv[1:]
+    out = None
+    while "-o" in args:
+        i = args.index("-o")
+        if i + 1 >= len(args):
+            sys.stderr.write(__doc__)
+            return 2
+        out = args[i + 1]
+        del args[i:i + 2]
+    if len(args) != 1:
+        sys.stderr.write(__doc__)
+        return 2
+    if out is None:
+        out = args[0]
+
+    with open(args[0], "rb") as f:
+        data = bytearray(f.read())
+    elf = Elf(data)
+    syms = elf.symbols()
+    for name in ("_data_start", "_data_end", "_data_load", "__data_lz4_size"):
+        if name not in syms:
+            sys.stderr.write("%s: no %s, not linked with headsail.ld and "
+                             "libgloss?\n" % (args[0], name))
+            return 1
+    start, end, load = syms["_data_start"], syms["_data_end"], syms["_data_load"]
+    if load == start:
+        sys.stderr.write("%s: .data is loaded in place, link with "
+                         "__data_load_addr set\n" % args[0])
+        return 1
+
+    for phoff, ptype, offset, vaddr, paddr, filesz, memsz in elf.segments():
+        if ptype == PT_LOAD and vaddr == start and paddr == load:
+            break
+    else:
+        sys.stderr.write("%s: no segment for the .data image\n" % args[0])
+        return 1
+    size_off = elf.file_offset(syms["__data_lz4_size"])
+    if size_off is None or struct.unpack_from("<I", data, size_off)[0]:
+        sys.stderr.write("%s: already compressed\n" % args[0])
+        return 1
+    if filesz != end - start or memsz != filesz:
+        sys.stderr.write("%s: the .data segment holds more than the image\n"
+                         % args[0])
+        return 1
+
+    image = lz4_compress(bytes(data[offset:offset + filesz]))
+    if len(image) >= filesz:
+        sys.stderr.write("%s: .data does not compress (%d bytes), left as "
+                         "is\n" % (args[0], filesz))
+    else:
+        data[offset:offset + len(image)] = image
+        # p_filesz and p_memsz
+        if elf.is64:
+            struct.pack_into("<QQ", data, phoff + 32, len(image), len(image))
+        else:
+            struct.pack_into("<II", data, phoff + 16, len(image), len(image))
+        # sh_size of .data and .sdata, for loaders that go by sections
+        elf.shrink_sections(offset, offset + filesz, offset + len(image))
+        struct.pack_into("<I", data, size_off, len(image))
+        sys.stdout.write(".data %d -> %d bytes\n" % (filesz, len(image)))
+
+    with open(out, "wb") as f:
+        f.write(data)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+# Copyright (C) SoCHub Finland 2024
+#
+# This copyrighted material is made available to anyone wishing to use,
+# modify, copy, or redistribute it subject to the terms and conditions
+# of the FreeBSD License.   This program is distributed in the hope that
+# it will be useful, but WITHOUT ANY WARRANTY expressed or implied,
+# including the implied warranties of MERCHANTABILITY or FITNESS FOR
+# A PARTICULAR PURPOSE.  A copy of this license is available at
+# http://www.opensource.org/licenses.
+
+"""Build a read-only filesystem image for <machine/romfs.h>.
+
+Usage: mkromfs.py [-C dir] [-a align] -o image.bin [-S image.S] path...
+
+Every path is a file or a directory, whose files are added recursively.
+Files are named by their path relative to dir (default: the current
+directory).  File data is aligned to align bytes (default 16), so that
+tables can be used in place through romfs_map.  -S also writes an
+assembler file that places the image in the .romfs section; compile and
+link it with the program:
+
+  mkromfs.py -C data -o romfs.bin -S romfs.S tables weights.bin
+  riscv64-unknown-elf-gcc ... main.c romfs.S -T headsail.ld
+"""
+
+import os
+import struct
+import sys
+
+ROMFS_MAGIC = 0x53464F52
+ROMFS_ALIGN = 64
+HEADER = struct.Struct("<IIII")
+ENTRY = struct.Struct("<IIII")
+
+
+def align(n, a):
+    return (n + a - 1) // a * a
+
+
+def collect(root, paths):
+    files = {}
+    for path in paths:
+        full = os.path.join(root, path)
+        if os.path.isdir(full):
+            for dirpath, dirnames, filenames in os.walk(full):
+                dirnames.sort()
+                for f in sorted(filenames):
+                    p = os.path.join(dirpath, f)
+                    files[os.path.relpath(p, root)] = p
+        else:
+            files[os.path.relpath(full, root)] = full
+    return {name.replace(os.sep, "/"): p for name, p in files.items()}
+
+
+def build(files, data_align):
+    # Sorted by the bytes of the name, as strcmp compares them
+    names = sorted(files, key=lambda n: n.encode())
+    strings = bytearray()
+    name_offsets = []
+    pos = HEADER.size + ENTRY.size * len(names)
+    for n in names:
+        name_offsets.append(pos + len(strings))
+        strings += n.encode() + b"\0"
+
+    image = bytearray(HEADER.size + ENTRY.size * len(names))
+    image += strings
+    entries = []
+    for n, name_off in zip(names, name_offsets):
+        with open(files[n], "rb") as f:
+            data = f.read()
+        image += bytes(align(len(image), data_align) - len(image))
+        entries.append((name_off, len(image), len(data)))
+        image += data
+
+    HEADER.pack_into(image, 0, ROMFS_MAGIC, len(names), len(image), 0)
+    for i, (name_off, offset, size) in enumerate(entries):
+        ENTRY.pack_into(image, HEADER.size + i * ENTRY.size,
+                        name_off, offset, size, 0)
+    image += bytes(align(len(image), ROMFS_ALIGN) - len(image))
+    return bytes(image)
+
+
+def main(argv):
+    args = argv[1:]
+    root = "."
+    data_align = 16
+    out = None
+    asm = None
+    for opt in ("-C", "-a", "-o", "-S"):
+        while opt in args:
+            i = args.index(opt)
+            if i + 1 >= len(args):
+                sys.stderr.write(__doc__)
+                return 2
+            value = args[i + 1]
+            del args[i:i + 2]
+            if opt == "-C":
+                root = value
+            elif opt == "-a":
+                data_align = int(value, 0)
+            elif opt == "-o":
+                out = value
+            else:
+                asm = value
+    if out is None or not args or data_align <= 0 \
+            or data_align & (data_align - 1) or data_align > ROMFS_ALIGN:
+        sys.stderr.write(__doc__)
+        return 2
+
+    files = collect(root, args)
+    image = build(files, data_align)
+    if len(image) >= 1 << 32:
+        sys.stderr.write("image too large\n")
+        return 1
+    with open(out, "wb") as f:
+        f.write(image)
+
+    if asm is not None:
+        with open(asm, "w") as f:
+            f.write("\t.section .romfs, \"a\"\n"
+                    "\t.balign %d\n"
+                    "\t.incbin \"%s\"\n" % (ROMFS_ALIGN, os.path.abspath(out)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,218 @@
+#!/usr/bin/env python3
+# Copyright (C) SoCHub Finland 2024
+#
+# This copyrighted material is made available to anyone wishing to use,
+# modify, copy, or redistribute it subject to the terms and conditions
+# of the FreeBSD License.   This program is distributed in the hope that
+# it will be useful, but WITHOUT ANY WARRANTY expressed or implied,
+# including the implied warranties of MERCHANTABILITY or FITNESS FOR
+# A PARTICULAR PURPOSE.  A copy of this license is available at
+# http://www.opensource.org/licenses.
+
+"""Worst-case stack depth of every function from GCC stack usage data.
+
+Usage: stack_report.py [--top N] [--path FUNCTION] dir-or-file...
+
+Reads the .su files of -fstack-usage and the .ci call graphs of
+-fcallgraph-info=su found under the given directories, as left next to
+the objects of a newlib build configured with both flags in
+CFLAGS_FOR_TARGET (see README.md).
+For every function it prints its own frame and the deepest stack of any
+call chain starting there, in bytes:
+
+    worst    own flag function (file:line:column)
+
+Flags mark results that are lower bounds only:
+
+  R  recursion was cut at the repeated function
+  D  a frame with dynamic size (alloca, VLA) is on the chain
+  I  an indirect call is on the chain, its callee is not counted
+  U  a callee without stack data (assembler, another library)
+
+--path prints the deepest chain of one function.
+"""
+
+import os
+import re
+import sys
+
+NODE = re.compile(r'node:\s*\{\s*title:\s*"((?:[^"\\]|\\.)*)"'
+                  r'\s*label:\s*"((?:[^"\\]|\\.)*)"([^}]*)\}')
+EDGE = re.compile(r'edge:\s*\{\s*sourcename:\s*"((?:[^"\\]|\\.)*)"'
+                  r'\s*targetname:\s*"((?:[^"\\]|\\.)*)"')
+BYTES = re.compile(r"^(\d+) bytes \(([a-z,]+)\)$")
+INDIRECT = "__indirect_call"
+
+
+class Function:
+    def __init__(self, name, location):
+        self.name = name
+        self.location = location
+        self.frame = None
+        self.dynamic = False
+        self.calls = []
+        self.worst = None
+        self.flags = ""
+        self.next = None
+
+
+def walk(paths):
+    for path in paths:
+        if os.path.isdir(path):
+            for dirpath, dirnames, filenames in os.walk(path):
+                dirnames.sort()
+                for f in sorted(filenames):
+                    yield os.path.join(dirpath, f)
+        else:
+            yield path
+
+
+def read_su(path, frames):
+    """file:line:col:function<TAB>bytes<TAB>qualifiers"""
+    with open(path, errors="replace") as f:
+        for line in f:
+            fields = line.rstrip("\n").split("\t")
+            if len(fields) < 3 or not fields[1].isdigit():
+                continue
+            loc, _, name = fields[0].rpartition(":")
+            frames[loc] = (name, int(fields[1]), "dynamic" in fields[2])
+
+
+def read_ci(path, functions, by_name, edges):
+    with open(path, errors="replace") as f:
+        text = f.read()
+    local = {}
+    for title, label, attrs in NODE.findall(text):
+        lines = label.split("\\n")
+        if "ellipse" in attrs or len(lines) < 2:
+            continue                        # declared only, or indirect
+        fn = Function(lines[0], lines[1])
+        for extra in lines[2:]:
+            m = BYTES.match(extra)
+            if m:
+                fn.frame = int(m.group(1))
+                fn.dynamic = "dynamic" in m.group(2)
+        local[title] = fn
+        functions.append(fn)
+        by_name.setdefault(title, []).append(fn)
+    for src, dst in EDGE.findall(text):
+        if src in local:
+            edges.append((local[src], dst, local))
+
+
+def resolve(functions, by_name, edges):
+    for fn, dst, local in edges:
+        if dst == INDIRECT:
+            fn.calls.append(None)
+        elif dst in local:
+            fn.calls.append(local[dst])
+        else:
+            # A global name defined in several objects (multilib variants
+            # of one source): take the deepest, as any could be linked
+            fn.calls.append(by_name.get(dst, [dst]))
+
+
+def depth(fn, active):
+    if fn.worst is not None:
+        return fn.worst, fn.flags
+    own = fn.frame or 0
+    flags = set()
+    if fn.frame is None:
+        flags.add("U")
+    if fn.dynamic:
+        flags.add("D")
+    best, best_next = 0, None
+    active.add(id(fn))
+    for callee in fn.calls:
+        if callee is None:
+            flags.add("I")
+            continue
+        for c in callee if isinstance(callee, list) else [callee]:
+            if isinstance(c, str):
+                flags.add("U")
+                continue
+            if id(c) in active:
+                flags.add("R")
+                continue
+            d, f = depth(c, active)
+            flags.update(f)
+            if d > best:
+                best, best_next = d, c
+    active.discard(id(fn))
+    fn.worst = own + best
+    fn.flags = "".join(sorted(flags))
+    fn.next = best_next
+    return fn.worst, fn.flags
+
+
+def main(argv):
+    args = argv[1:]
+    top = None
+    path_of = None
+    for opt in ("--top", "--path"):
+        while opt in args:
+            i = args.index(opt)
+            if i + 1 >= len(args):
+                sys.stderr.write(__doc__)
+                return 2
+            if opt == "--top":
+                top = int(args[i + 1])
+            else:
+                path_of = args[i + 1]
+            del args[i:i + 2]
+    if not args:
+        sys.stderr.write(__doc__)
+        return 2
+
+    frames = {}
+    functions, by_name, edges = [], {}, []
+    files = list(walk(args))
+    for f in files:
+        if f.endswith(".su"):
+            read_su(f, frames)
+    for f in files:
+        if f.endswith(".ci"):
+            read_ci(f, functions, by_name, edges)
+
+    # Graphs without su markers: frame sizes come from the .su files
+    for fn in functions:
+        if fn.frame is None and fn.location in frames:
+            _, fn.frame, fn.dynamic = frames[fn.location]
+    if not functions:
+        # No call graphs at all: report the frames alone
+        for loc, (name, size, dynamic) in frames.items():
+            fn = Function(name, loc)
+            fn.frame = size
+            fn.dynamic = dynamic
+            functions.append(fn)
+    resolve(functions, by_name, edges)
+
+    sys.setrecursionlimit(max(10000, 4 * len(functions)))
+    for fn in functions:
+        depth(fn, set())
+
+    out = sys.stdout
+    if path_of is not None:
+        chains = [fn for fn in functions if fn.name == path_of]
+        if not chains:
+            sys.stderr.write("%s: no such function\n" % path_of)
+            return 1
+        fn = max(chains, key=lambda f: f.worst)
+        while fn is not None:
+            out.write("%8d %6d %-4s %s (%s)\n" % (
+                fn.worst, fn.frame or 0, fn.flags, fn.name, fn.location))
+            fn = fn.next
+        return 0
+
+    functions.sort(key=lambda f: (-f.worst, f.name))
+    if top is not None:
+        functions = functions[:top]
+    out.write("%8s %6s %-4s %s\n" % ("worst", "own", "flag", "function"))
+    for fn in functions:
+        out.write("%8d %6d %-4s %s (%s)\n" % (
+            fn.worst, fn.frame or 0, fn.flags, fn.name, fn.location))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,43 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * RAM trace buffer console backend, see tracebuf.h.
+ */
+
+#include <string.h>
+#include "tracebuf.h"
+
+struct tracebuf __trace_buffer __attribute__((aligned(8)));
+
+size_t
+tracebuf_write(const char *buf, size_t len)
+{
+  uint64_t head = __trace_buffer.head;
+  size_t copy = len;
+  size_t offset, chunk;
+
+  /* Filled in here rather than statically, crt0 clears .bss */
+  __trace_buffer.magic = TRACEBUF_MAGIC;
+  __trace_buffer.size = TRACEBUF_SIZE;
+
+  /* Only the last TRACEBUF_SIZE bytes can survive */
+  if (copy > TRACEBUF_SIZE)
+  {
+    buf += copy - TRACEBUF_SIZE;
+    head += copy - TRACEBUF_SIZE;
+    copy = TRACEBUF_SIZE;
+  }
+
+  offset = head % TRACEBUF_SIZE;
+  chunk = TRACEBUF_SIZE - offset;
+  if (chunk > copy) chunk = copy;
+
+  memcpy(&__trace_buffer.data[offset], buf, chunk);
+  memcpy(&__trace_buffer.data[0], buf + chunk, copy - chunk);
+
+  /* Publish the data before the new head */
+  __asm__ volatile ("fence w, w" ::: "memory");
+  __trace_buffer.head = head + copy;
+
+  return len;
+}
@@ -0,0 +1,43 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * RAM trace buffer console backend, linked in with trace.specs.
+ *
+ * Console output is appended to __trace_buffer, a circular buffer that
+ * a debugger, the virtual prototype or a simulator reads through its
+ * ELF symbol. The writer never waits: when the reader falls behind, the
+ * oldest data is overwritten.
+ *
+ * head counts every byte ever written, so data[head % size] is the next
+ * byte to be written. A reader keeps its own position in tail; if
+ * head - tail exceeds size, head - tail - size bytes were overwritten
+ * before they could be read.
+ */
+
+#ifndef _RISCV_TRACEBUF_H
+#define _RISCV_TRACEBUF_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Must be a power of two */
+#ifndef TRACEBUF_SIZE
+#define TRACEBUF_SIZE	16384
+#endif
+
+#define TRACEBUF_MAGIC	0x46425254	/* "TRBF" */
+
+struct tracebuf
+{
+  uint32_t magic;
+  uint32_t size;
+  volatile uint64_t head;	/* Written by the target */
+  volatile uint64_t tail;	/* Written by the reader */
+  char data[TRACEBUF_SIZE];
+};
+
+extern struct tracebuf __trace_buffer;
+
+size_t tracebuf_write(const char *buf, size_t len);
+
+#endif /* _RISCV_TRACEBUF_H */
@@ -0,0 +1,130 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * Machine-mode trap dispatch for Headsail, see <machine/trap.h>.
+ * trap_entry.S calls the interrupt handlers in __trap_interrupt_table
+ * directly and the exception handlers through __trap_exception.
+ */
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "encoding.h"
+#include "plic.h"
+#include "timer.h"
+#include "trap.h"
+
+static void external_interrupt(unsigned long cause, uintptr_t mepc);
+
+trap_handler_t __trap_interrupt_table[TRAP_CAUSES] =
+{
+  [0 ... TRAP_CAUSES - 1] = __trap_unexpected,
+  [IRQ_M_TIMER] = timer_isr,
+  [IRQ_M_EXT] = external_interrupt,
+};
+
+void (*volatile __trap_hook)(unsigned long, uintptr_t, unsigned long);
+
+static trap_exception_t exception_table[TRAP_CAUSES];
+
+static void (*external_table[PLIC_SOURCES])(unsigned int source);
+
+/* An interrupt nobody asked for would retrigger forever, mask it. Also
+   called for the causes above TRAP_CAUSES, which have no slot.  */
+void
+__trap_unexpected(unsigned long cause, uintptr_t mepc)
+{
+  if (cause < __riscv_xlen)
+    clear_csr(mie, 1UL << cause);
+}
+
+static void
+external_interrupt(unsigned long cause, uintptr_t mepc)
+{
+  unsigned int irq;
+
+  while ((irq = plic_claim()) != 0)
+  {
+    if (irq < PLIC_SOURCES && external_table[irq] != NULL)
+      external_table[irq](irq);
+    plic_complete(irq);
+  }
+}
+
+int
+trap_set_interrupt(unsigned int cause, trap_handler_t fn)
+{
+  if (cause >= TRAP_CAUSES)
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  if (fn == NULL)
+  {
+    clear_csr(mie, 1UL << cause);
+    if (cause == IRQ_M_TIMER)
+      fn = timer_isr;
+    else if (cause == IRQ_M_EXT)
+      fn = external_interrupt;
+    else
+      fn = __trap_unexpected;
+    __trap_interrupt_table[cause] = fn;
+    return 0;
+  }
+
+  __trap_interrupt_table[cause] = fn;
+  set_csr(mie, 1UL << cause);
+  return 0;
+}
+
+int
+trap_set_exception(unsigned int cause, trap_exception_t fn)
+{
+  if (cause >= TRAP_CAUSES)
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  exception_table[cause] = fn;
+  return 0;
+}
+
+int
+trap_set_external(unsigned int source, void (*fn)(unsigned int source),
+		  unsigned int priority)
+{
+  if (source == 0 || source >= PLIC_SOURCES)
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  if (fn == NULL)
+  {
+    plic_disable(source);
+    external_table[source] = NULL;
+    return 0;
+  }
+
+  external_table[source] = fn;
+  plic_enable(source, priority);
+  set_csr(mie, MIP_MEIP);
+  return 0;
+}
+
+void
+__trap_exception(struct trap_frame *frame)
+{
+  unsigned long cause = frame->mcause;
+
+  if (cause < TRAP_CAUSES && exception_table[cause] != NULL)
+  {
+    exception_table[cause](frame);
+    return;
+  }
+
+  /* Unhandled exceptions are fatal, trap execution like _exit does */
+  while (1);
+}
@@ -0,0 +1,26 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * Dispatch state shared between trap_entry.S, trap.c and the latency
+ * measurement. The public interface is <machine/trap.h>.
+ */
+
+#ifndef _RISCV_TRAP_H
+#define _RISCV_TRAP_H
+
+#include <machine/trap.h>
+
+/* Interrupt handlers, indexed by cause, read by the vector stubs */
+extern trap_handler_t __trap_interrupt_table[TRAP_CAUSES];
+
+/* Masks the interrupt cause in mie, the default handler and the one of
+   the causes from TRAP_CAUSES to XLEN - 1 */
+void __trap_unexpected(unsigned long cause, uintptr_t mepc);
+
+/* When set, the interrupt path calls the hook instead of the handler.
+   entry is the low word of mcycle at the first instruction of the
+   stub; the hook calls the handler itself.  */
+extern void (*volatile __trap_hook)(unsigned long cause, uintptr_t mepc,
+				    unsigned long entry);
+
+#endif /* _RISCV_TRAP_H */
@@ -0,0 +1,124 @@
+/**
+ * Copyright (C) SoCHub Finland 2024
+ *
+ * Interrupt latency measurement, see <machine/trap.h>.
+ *
+ * While enabled, the interrupt path of trap_entry.S calls latency_hook
+ * instead of the handler, passing the mcycle value taken by the vector
+ * stub. Only the low word of mcycle is compared, which is enough for
+ * the intervals measured here on RV32 as well. The statistics are
+ * thread-local, so every hart records its own without locking; they
+ * live in this file so that programs that never measure do not carry
+ * them in their TLS blocks.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <machine/cycles.h>
+#include "clint.h"
+#include "console.h"
+#include "encoding.h"
+#include "trap.h"
+
+static __thread struct trap_latency trap_stats[TRAP_CAUSES];
+
+static void
+latency_hook(unsigned long cause, uintptr_t mepc, unsigned long entry)
+{
+  unsigned long start = read_csr(mcycle);
+  struct trap_latency *s = &trap_stats[cause];
+  uint32_t entry_cycles = start - entry;
+  uint32_t handler_cycles;
+  uint64_t response = 0;
+  uint64_t now, cmp;
+
+  if (cause == IRQ_M_TIMER)
+  {
+    now = timebase_read();
+    cmp = CLINT_MTIMECMP(read_csr(mhartid));
+    if (now > cmp)
+      response = (now - cmp) * cpu_freq / timebase_freq;
+  }
+
+  __trap_interrupt_table[cause](cause, mepc);
+  handler_cycles = read_csr(mcycle) - start;
+
+  if (s->count == 0 || entry_cycles < s->entry_min)
+    s->entry_min = entry_cycles;
+  if (entry_cycles > s->entry_max)
+    s->entry_max = entry_cycles;
+  if (handler_cycles > s->handler_max)
+    s->handler_max = handler_cycles;
+  if (response > s->response_max)
+    s->response_max = response;
+  s->entry_total += entry_cycles;
+  s->handler_total += handler_cycles;
+  s->count++;
+}
+
+void
+trap_latency_enable(int on)
+{
+  __trap_hook = on ? latency_hook : NULL;
+}
+
+int
+trap_latency_get(unsigned int cause, struct trap_latency *stats)
+{
+  unsigned long flags;
+
+  if (cause >= TRAP_CAUSES)
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  flags = irq_save();
+  *stats = trap_stats[cause];
+  irq_restore(flags);
+  return 0;
+}
+
+void
+trap_latency_reset(void)
+{
+  unsigned long flags = irq_save();
+
+  memset(trap_stats, 0, sizeof(trap_stats));
+  irq_restore(flags);
+}
+
+void
+trap_latency_report(void)
+{
+  struct trap_latency s;
+  unsigned int cause;
+
+  for (cause = 0; cause < TRAP_CAUSES; cause++)
+  {
+    trap_latency_get(cause, &s);
+    if (s.count == 0)
+      continue;
+
+    console_puts("irq ");
+    console_putu(cause);
+    console_puts(": count ");
+    console_putu(s.count);
+    console_puts(" entry min/avg/max ");
+    console_putu(s.entry_min);
+    console_puts("/");
+    console_putu(s.entry_total / s.count);
+    console_puts("/");
+    console_putu(s.entry_max);
+    console_puts(" handler avg/max ");
+    console_putu(s.handler_total / s.count);
+    console_puts("/");
+    console_putu(s.handler_max);
+    if (cause == IRQ_M_TIMER)
+    {
+      console_puts(" response max ");
+      console_putu(s.response_max);
+    }
+    console_puts(" cycles\n");
+  }
+}
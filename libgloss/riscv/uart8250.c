@@ -12,7 +12,12 @@
  * file.
  */
 #include <uart8250.h>
+#include <machine/uart.h>
 #include <stdint.h>
+#include <string.h>
+#include "encoding.h"
+#include <machine/cycles.h>
+#include <machine/trap.h>
 
 /* clang-format off */
 
@@ -40,33 +45,95 @@
 #define UART_LSR_DR				0x01	/* Receiver data ready */
 #define UART_LSR_BRK_ERROR_BITS	0x1E	/* BI, FE, PE, OE bits */
 
+#define UART_IER_RDI			0x01	/* Enable receiver data interrupt */
+#define UART_IER_THRI			0x02	/* Enable transmitter holding register int. */
+
+#define UART_IIR_NO_INT			0x01	/* No interrupts pending */
+#define UART_IIR_ID				0x0E	/* Mask for the interrupt ID */
+#define UART_IIR_MSI			0x00	/* Modem status interrupt */
+#define UART_IIR_THRI			0x02	/* Transmitter holding register empty */
+#define UART_IIR_RDI			0x04	/* Receiver data interrupt */
+#define UART_IIR_RLSI			0x06	/* Receiver line status interrupt */
+#define UART_IIR_RX_TIMEOUT		0x0C	/* Receiver character timeout */
+
+#define UART_FCR_FIFO_EN		0x01	/* Enable FIFOs */
+#define UART_FCR_CLEAR_RX		0x02	/* Clear receive FIFO */
+#define UART_FCR_CLEAR_TX		0x04	/* Clear transmit FIFO */
+#define UART_FCR_TRIGGER_SHIFT	6		/* Receive trigger level field */
+
 /* clang-format on */
 
+#if UART8250_REG_WIDTH == 1
+typedef uint8_t uart8250_reg_t;
+#elif UART8250_REG_WIDTH == 2
+typedef uint16_t uart8250_reg_t;
+#elif UART8250_REG_WIDTH == 4
+typedef uint32_t uart8250_reg_t;
+#else
+#error "UART8250_REG_WIDTH must be 1, 2 or 4"
+#endif
+
+/* Default configuration, same values as used by openSBI on Headsail */
+__attribute__((weak))
+const struct uart8250_config uart8250_config = {
+	.base			= 0x1FFF00000,
+	.in_freq		= 1000000,
+	.baudrate		= 115200,
+	.fifo_trigger	= UART8250_FIFO_TRIGGER_1,
+	.fifo_depth		= 16,
+	.irq			= 0,
+};
+
 static volatile char *uart8250_base;
-static uint32_t uart8250_in_freq;
-static uint32_t uart8250_baudrate;
-static uint32_t uart8250_reg_width;
-static uint32_t uart8250_reg_shift;
+static uint32_t uart8250_fifo_depth;
+static uint8_t uart8250_ier;
 
-uint32_t get_reg(uint32_t num)
-{
-	uint32_t offset = num << uart8250_reg_shift;
+/**
+ * Guards the rings, their indexes, the IER shadow and the FIFO bursts
+ * against the other harts. It is taken with machine interrupts masked,
+ * so the interrupt handler never spins on a lock held by its own hart.
+ */
+static int uart8250_lock;
+
+/**
+ * Transmit ring, filled by _write and drained into the FIFO by the THRE
+ * interrupt. The indexes run freely and are reduced modulo the size on
+ * access, so head - tail is always the number of queued bytes.
+ */
+static char uart8250_tx_ring[UART8250_TX_RING_SIZE];
+static volatile size_t uart8250_tx_head;
+static volatile size_t uart8250_tx_tail;
+
+/** Set when the UART interrupt drives both the transmit and receive rings */
+static int uart8250_irq;
+
+/**
+ * Receive ring, filled by the receive interrupt or, in polled mode, by
+ * the reader itself. Same index scheme as the transmit ring.
+ */
+static char uart8250_rx_ring[UART8250_RX_RING_SIZE];
+static volatile size_t uart8250_rx_head;
+static volatile size_t uart8250_rx_tail;
+static volatile size_t uart8250_rx_lost;
 
-	if (uart8250_reg_width == 1) return *(uart8250_base + offset);
-	else if (uart8250_reg_width == 2) return *(uart8250_base + offset);
-	else return *(uart8250_base + offset);
+/* Read mode, see uart_rx_mode() */
+static unsigned int uart8250_rx_vmin = 1;
+static unsigned int uart8250_rx_vtime;
+static unsigned int uart8250_rx_flags = UART_RX_ECHO;
+
+static inline uint32_t get_reg(uint32_t num)
+{
+	return *(volatile uart8250_reg_t *)(uart8250_base +
+					     (num << UART8250_REG_SHIFT));
 }
 
-void set_reg(
-    uint32_t num, 
+static inline void set_reg(
+    uint32_t num,
     uint32_t val
 )
 {
-	uint32_t offset = num << uart8250_reg_shift;
-
-	if (uart8250_reg_width == 1) *(uart8250_base + offset) = val;
-	else if (uart8250_reg_width == 2) *(uart8250_base + offset) = val;
-	else *(uart8250_base + offset) = val;
+	*(volatile uart8250_reg_t *)(uart8250_base +
+				      (num << UART8250_REG_SHIFT)) = val;
 }
 
 void uart8250_putc(char ch)
@@ -76,6 +143,277 @@ void uart8250_putc(char ch)
 	set_reg(UART_THR_OFFSET, ch);
 }
 
+size_t uart8250_write(const char *buf, size_t len)
+{
+	size_t left = len;
+	size_t burst;
+
+	while (left)
+	{
+		/* One burst per hart at a time, or the FIFO would overflow */
+		spin_lock(&uart8250_lock);
+
+		/* THRE with FIFOs enabled means the whole transmit FIFO is free */
+		while ((get_reg(UART_LSR_OFFSET) & UART_LSR_THRE) == 0);
+
+		burst = left < uart8250_fifo_depth ? left : uart8250_fifo_depth;
+		left -= burst;
+		while (burst--) set_reg(UART_THR_OFFSET, *buf++);
+
+		spin_unlock(&uart8250_lock);
+	}
+
+	return len;
+}
+
+/**
+ * Move queued bytes into the transmit FIFO if it is empty, and keep the
+ * THRE interrupt enabled only while the ring holds data. Must be called
+ * with uart8250_lock held.
+ */
+static void uart8250_tx_kick(void)
+{
+	size_t tail = uart8250_tx_tail;
+	size_t burst = uart8250_fifo_depth;
+	uint8_t ier;
+
+	if (get_reg(UART_LSR_OFFSET) & UART_LSR_THRE)
+	{
+		while (burst-- && tail != uart8250_tx_head)
+		{
+			set_reg(UART_THR_OFFSET,
+				uart8250_tx_ring[tail % UART8250_TX_RING_SIZE]);
+			tail++;
+		}
+		uart8250_tx_tail = tail;
+	}
+
+	if (tail != uart8250_tx_head) ier = uart8250_ier | UART_IER_THRI;
+	else ier = uart8250_ier & ~UART_IER_THRI;
+
+	if (ier != uart8250_ier)
+	{
+		uart8250_ier = ier;
+		set_reg(UART_IER_OFFSET, ier);
+	}
+}
+
+size_t uart8250_enqueue(const char *buf, size_t len)
+{
+	size_t left = len;
+	size_t head, room, chunk;
+	unsigned long flags;
+
+	if (!uart8250_irq) return uart8250_write(buf, len);
+
+	while (left)
+	{
+		flags = irq_save();
+		spin_lock(&uart8250_lock);
+
+		head = uart8250_tx_head;
+		room = UART8250_TX_RING_SIZE - (head - uart8250_tx_tail);
+		if (room > left) room = left;
+		left -= room;
+
+		while (room)
+		{
+			/* Copy up to the physical end of the ring at a time */
+			chunk = UART8250_TX_RING_SIZE - head % UART8250_TX_RING_SIZE;
+			if (chunk > room) chunk = room;
+			memcpy(&uart8250_tx_ring[head % UART8250_TX_RING_SIZE], buf, chunk);
+			buf += chunk;
+			head += chunk;
+			room -= chunk;
+		}
+		uart8250_tx_head = head;
+
+		/**
+		 * Start transmission right away. This also guarantees progress
+		 * when the ring is full and interrupts are disabled by the caller.
+		 */
+		uart8250_tx_kick();
+
+		spin_unlock(&uart8250_lock);
+		irq_restore(flags);
+	}
+
+	return len;
+}
+
+/**
+ * Move everything in the receive FIFO into the receive ring. Bytes that
+ * do not fit are dropped and counted, as are hardware overruns. Must be
+ * called with uart8250_lock held.
+ */
+static void uart8250_rx_drain(void)
+{
+	size_t head = uart8250_rx_head;
+	uint32_t lsr;
+	char ch;
+
+	while ((lsr = get_reg(UART_LSR_OFFSET)) & UART_LSR_DR)
+	{
+		ch = get_reg(UART_RBR_OFFSET);
+		if (lsr & UART_LSR_OE) uart8250_rx_lost++;
+
+		if (head - uart8250_rx_tail == UART8250_RX_RING_SIZE)
+		{
+			uart8250_rx_lost++;
+			continue;
+		}
+		uart8250_rx_ring[head % UART8250_RX_RING_SIZE] = ch;
+		head++;
+	}
+
+	uart8250_rx_head = head;
+}
+
+/* Copy up to len bytes out of the receive ring */
+static size_t uart8250_rx_take(char *buf, size_t len)
+{
+	size_t tail, avail, chunk, n;
+	unsigned long flags;
+
+	flags = irq_save();
+	spin_lock(&uart8250_lock);
+
+	if (!uart8250_irq) uart8250_rx_drain();
+
+	tail = uart8250_rx_tail;
+
+	avail = uart8250_rx_head - tail;
+	n = avail < len ? avail : len;
+
+	for (avail = n; avail; avail -= chunk)
+	{
+		chunk = UART8250_RX_RING_SIZE - tail % UART8250_RX_RING_SIZE;
+		if (chunk > avail) chunk = avail;
+		memcpy(buf, &uart8250_rx_ring[tail % UART8250_RX_RING_SIZE], chunk);
+		buf += chunk;
+		tail += chunk;
+	}
+
+	uart8250_rx_tail = tail;
+
+	spin_unlock(&uart8250_lock);
+	irq_restore(flags);
+	return n;
+}
+
+/**
+ * Termios-style read: VMIN is the number of bytes to wait for, VTIME is
+ * a timeout in tenths of a second, measured from the call when VMIN is
+ * zero and from the last received byte otherwise.
+ */
+ssize_t uart8250_read(char *buf, size_t len)
+{
+	size_t want = uart8250_rx_vmin < len ? uart8250_rx_vmin : len;
+	uint64_t timeout = (uint64_t)uart8250_rx_vtime * timebase_freq / 10;
+	uint64_t last = timebase_read();
+	size_t got = 0;
+	size_t n;
+
+	if (len == 0) return 0;
+
+	for (;;)
+	{
+		n = uart8250_rx_take(buf + got, len - got);
+		if (n)
+		{
+			got += n;
+			last = timebase_read();
+		}
+
+		if (got == len || (want && got >= want)) return got;
+
+		if (uart8250_rx_flags & UART_RX_NONBLOCK) return got ? got : -1;
+
+		if (!uart8250_rx_vtime)
+		{
+			if (!want) return got;
+		}
+		else if (!want && got) return got;
+		else if ((!want || got) && timebase_read() - last >= timeout)
+			return got;
+	}
+}
+
+void uart8250_isr(unsigned int irq)
+{
+	uint32_t iir;
+
+	spin_lock(&uart8250_lock);
+	while (((iir = get_reg(UART_IIR_OFFSET)) & UART_IIR_NO_INT) == 0)
+	{
+		switch (iir & UART_IIR_ID)
+		{
+		case UART_IIR_THRI:
+			uart8250_tx_kick();
+			break;
+		case UART_IIR_RDI:
+		case UART_IIR_RX_TIMEOUT:
+			uart8250_rx_drain();
+			break;
+		case UART_IIR_MSI:
+			get_reg(UART_MSR_OFFSET);
+			break;
+		default:
+			/* Reading LSR clears any line status interrupt */
+			get_reg(UART_LSR_OFFSET);
+			break;
+		}
+	}
+	spin_unlock(&uart8250_lock);
+}
+
+int uart_rx_mode(unsigned int vmin, unsigned int vtime, unsigned int flags)
+{
+	uart8250_rx_vmin  = vmin;
+	uart8250_rx_vtime = vtime;
+	uart8250_rx_flags = flags;
+
+	return 0;
+}
+
+unsigned int uart_rx_flags(void)
+{
+	return uart8250_rx_flags;
+}
+
+size_t uart_rx_pending(void)
+{
+	return uart8250_rx_head - uart8250_rx_tail;
+}
+
+size_t uart_rx_lost(void)
+{
+	return uart8250_rx_lost;
+}
+
+size_t uart_tx_pending(void)
+{
+	return uart8250_tx_head - uart8250_tx_tail;
+}
+
+void uart_flush(void)
+{
+	unsigned long flags;
+
+	if (!uart8250_base) return;
+
+	while (uart_tx_pending())
+	{
+		flags = irq_save();
+		spin_lock(&uart8250_lock);
+		uart8250_tx_kick();
+		spin_unlock(&uart8250_lock);
+		irq_restore(flags);
+	}
+
+	while ((get_reg(UART_LSR_OFFSET) & UART_LSR_TEMT) == 0);
+}
+
 char uart8250_getc(void)
 {
 	while ((get_reg(UART_LSR_OFFSET) & UART_LSR_DR) == 0);
@@ -84,38 +422,26 @@ char uart8250_getc(void)
 }
 
 /**
- * At the original implementation, this init function took a 
- * number of arguments such as the base address and Baud rate.
- * 
- * In order to reduce the amount of workload for the newlib user,
- * these arguments have been phased out and their default values 
- * are the same as those used in openSBI.
- * 
- * The arguments are kept so that the driver may be restored in 
- * some later iteration of newlib.
+ * The board parameters used to be hard-coded here. They now come from
+ * the configuration structure, whose weak default (uart8250_config)
+ * carries the values used by openSBI. Register stride is a build-time
+ * setting, see uart8250.h.
  */
-int uart8250_init()
+int uart8250_init(const struct uart8250_config *config)
 {
-	/** Original arguments start */
-	unsigned long base 	= 0x1FFF00000;
-    uint32_t in_freq	= 1000000;
-    uint32_t baudrate	= 115200;
-    uint32_t reg_shift	= 0;
-	uint32_t reg_width	= 1;
-    uint32_t reg_offset	= 0;
-	/** Original arguments end */
-
+#if defined(USING_SEMIHOSTING) || defined(USING_HTIF)
+	/* The console is the host's, simulators have no UART here */
+	(void)config;
+	return 0;
+#else
 	uint16_t bdiv 		= 0;
 
-	uart8250_base      = (volatile char *)base + reg_offset;
-	uart8250_reg_shift = reg_shift;
-	uart8250_reg_width = reg_width;
-	uart8250_in_freq   = in_freq;
-	uart8250_baudrate  = baudrate;
+	uart8250_base       = (volatile char *)config->base;
+	uart8250_fifo_depth = config->fifo_depth ? config->fifo_depth : 1;
 
-	if (uart8250_baudrate) {
-		bdiv = (uart8250_in_freq + 8 * uart8250_baudrate) /
-		       (16 * uart8250_baudrate);
+	if (config->baudrate) {
+		bdiv = (config->in_freq + 8 * config->baudrate) /
+		       (16 * config->baudrate);
 	}
 
 	/* Disable all interrupts */
@@ -132,8 +458,10 @@ int uart8250_init()
 
 	/* 8 bits, no parity, one stop bit */
 	set_reg(UART_LCR_OFFSET, 0x03);
-	/* Enable FIFO */
-	set_reg(UART_FCR_OFFSET, 0x01);
+	/* Enable and reset FIFOs, set the receive trigger level */
+	set_reg(UART_FCR_OFFSET, UART_FCR_FIFO_EN | UART_FCR_CLEAR_RX |
+		UART_FCR_CLEAR_TX |
+		((config->fifo_trigger & 0x3) << UART_FCR_TRIGGER_SHIFT));
 	/* No modem control DTR RTS */
 	set_reg(UART_MCR_OFFSET, 0x00);
 	/* Clear line status */
@@ -143,5 +471,20 @@ int uart8250_init()
 	/* Set scratchpad */
 	set_reg(UART_SCR_OFFSET, 0x00);
 
+	/**
+	 * With an interrupt line configured, transmission becomes buffered
+	 * and reception is interrupt driven. The THRE interrupt itself is
+	 * only enabled while data is queued.
+	 */
+	uart8250_ier = 0;
+	uart8250_irq = config->irq != 0;
+	if (uart8250_irq) {
+		uart8250_ier = UART_IER_RDI;
+		set_reg(UART_IER_OFFSET, uart8250_ier);
+		trap_set_external(config->irq, uart8250_isr, 1);
+		set_csr(mstatus, MSTATUS_MIE);
+	}
+
 	return 0;
-}
\ No newline at end of file
+#endif
+}
@@ -8,31 +8,115 @@
  *   Anup Patel <anup.patel@wdc.com>
  *   Andreas Stergiopoulos <andreas.stergiopoulos@tuni.fi>
  *
- * This is a bare-metal driver for the 8250 UART module. This driver 
+ * This is a bare-metal driver for the 8250 UART module. This driver
  * is a modified version of the original 8250 UART driver found in the
  * RISCV OpenSBI repo.
- * 
- * The actual silicon and the virtual prototype implement the NS16650 
- * hardware, which is backwards compativle to the 8250. Their difference is 
- * that the NS16650 is FIFO-based and thus better for multiprogramming 
- * environments, but in this case where we do bare-metal programming, 
- * the FIFO does not provide any significant advantage.
  *
- * To use this driver, the user should first call the UART 
- * initialization function in order to bring the hardware to a 
+ * The actual silicon and the virtual prototype implement the NS16650
+ * hardware, which is backwards compativle to the 8250. The NS16650 has
+ * a 16-byte transmit FIFO, so instead of polling the line status once
+ * per byte, uart8250_write() refills the whole FIFO every time the
+ * transmit holding register reports empty.
+ *
+ * To use this driver, the user should first call the UART
+ * initialization function in order to bring the hardware to a
  * known state.
+ *
+ * The register stride is fixed at compile time, so that register
+ * accesses do not branch on it. Define UART8250_REG_SHIFT and
+ * UART8250_REG_WIDTH (1, 2 or 4 bytes) when building libgloss for a
+ * UART that does not use byte-wide, byte-spaced registers.
+ *
+ * When the configuration names a PLIC interrupt source, transmission is
+ * buffered: uart8250_enqueue() copies into a ring of
+ * UART8250_TX_RING_SIZE bytes and returns, and the THRE interrupt
+ * drains the ring into the FIFO. Received bytes are moved into a ring
+ * of UART8250_RX_RING_SIZE bytes by the receive interrupt, so input that
+ * arrives while the hart is busy is not lost to a FIFO overrun. Without
+ * an interrupt source the driver stays fully polled.
  */
 
 #ifndef __SERIAL_UART8250_H__
 #define __SERIAL_UART8250_H__
 
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifndef UART8250_REG_SHIFT
+#define UART8250_REG_SHIFT	0
+#endif
+
+#ifndef UART8250_REG_WIDTH
+#define UART8250_REG_WIDTH	1
+#endif
+
+/* Must be a power of two */
+#ifndef UART8250_TX_RING_SIZE
+#define UART8250_TX_RING_SIZE	1024
+#endif
+
+/* Must be a power of two */
+#ifndef UART8250_RX_RING_SIZE
+#define UART8250_RX_RING_SIZE	256
+#endif
+
+/* Receive FIFO trigger levels, as encoded in FCR[7:6] */
+#define UART8250_FIFO_TRIGGER_1		0
+#define UART8250_FIFO_TRIGGER_4		1
+#define UART8250_FIFO_TRIGGER_8		2
+#define UART8250_FIFO_TRIGGER_14	3
+
 /**
- * 
+ * Board configuration of the console UART.
  */
-int uart8250_init();
+struct uart8250_config
+{
+	unsigned long base;		/* Base address of the register block */
+	uint32_t in_freq;		/* Input clock frequency in Hz */
+	uint32_t baudrate;		/* Line rate, 0 keeps the current divisor */
+	uint8_t fifo_trigger;	/* One of UART8250_FIFO_TRIGGER_* */
+	uint8_t fifo_depth;		/* Transmit FIFO depth in bytes, 1 for an 8250 */
+	uint16_t irq;			/* PLIC interrupt source, 0 for polled mode */
+};
+
+/**
+ * Configuration used by crt0. The library provides a weak default
+ * matching the Headsail virtual prototype; a board overrides it by
+ * defining its own uart8250_config object.
+ */
+extern const struct uart8250_config uart8250_config;
+
+int uart8250_init(const struct uart8250_config *config);
 
 void uart8250_putc(char ch);
 
+/**
+ * Transmit len bytes from buf, filling the transmit FIFO up to its depth
+ * each time it drains. Returns once the last byte is in the FIFO.
+ */
+size_t uart8250_write(const char *buf, size_t len);
+
+/**
+ * Queue len bytes for interrupt-driven transmission. Returns as soon as
+ * everything has been copied into the transmit ring, waiting only while
+ * the ring is full. Falls back to uart8250_write() in polled mode.
+ */
+size_t uart8250_enqueue(const char *buf, size_t len);
+
+/**
+ * UART interrupt handler, registered with trap_set_external() for the
+ * configured PLIC source.
+ */
+void uart8250_isr(unsigned int irq);
+
 char uart8250_getc(void);
 
+/**
+ * Read up to len received bytes following the mode set with
+ * uart_rx_mode(). Returns -1 if the read is non-blocking and nothing
+ * has been received.
+ */
+ssize_t uart8250_read(char *buf, size_t len);
+
 #endif
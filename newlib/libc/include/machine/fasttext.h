@@ -0,0 +1,14 @@
+#ifndef	_MACHFASTTEXT_H_
+#define	_MACHFASTTEXT_H_
+
+/* Placement of hot library routines in fast instruction memory.
+   _FAST_TEXT (name) marks the definition of one of them; platforms with
+   such memory override this header.  By default routines stay in .text.  */
+
+#define _FAST_TEXT(name)
+
+#ifdef __ASSEMBLER__
+#define _FAST_TEXT_SECTION(name) .text
+#endif
+
+#endif	/* _MACHFASTTEXT_H_ */
@@ -401,6 +401,14 @@ extern "C" {
 
 #endif
 
+/* The Headsail libgloss port provides clock_gettime, clock_nanosleep and
+   the monotonic and CPU-time clocks, but no timer_create.  */
+#ifdef __HEADSAIL__
+#define _POSIX_MONOTONIC_CLOCK			200112L
+#define _POSIX_CPUTIME				1
+#define _POSIX_CLOCK_SELECTION			200112L
+#endif
+
 /* XMK loosely adheres to POSIX -- 1003.1 */
 #ifdef __XMK__
 #define _POSIX_THREADS				1
@@ -153,9 +153,8 @@ extern __IMPORT char *_tzname[2];
 #include <cygwin/time.h>
 #endif /*__CYGWIN__*/
 
-#if defined(_POSIX_TIMERS)
-
-#include <signal.h>
+/* Headsail has the clocks and nanosleep, but not the per-process timers */
+#if defined(_POSIX_TIMERS) || defined(__HEADSAIL__)
 
 #ifdef __cplusplus
 extern "C" {
@@ -167,6 +166,23 @@ int clock_settime (clockid_t clock_id, const struct timespec *tp);
 int clock_gettime (clockid_t clock_id, struct timespec *tp);
 int clock_getres (clockid_t clock_id, struct timespec *res);
 
+/* High Resolution Sleep, P1003.1b-1993, p. 269 */
+
+int nanosleep (const struct timespec  *rqtp, struct timespec *rmtp);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* _POSIX_TIMERS || __HEADSAIL__ */
+
+#if defined(_POSIX_TIMERS)
+
+#include <signal.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /* Create a Per-Process Timer, P1003.1b-1993, p. 264 */
 
 int timer_create (clockid_t clock_id,
@@ -185,10 +201,6 @@ int timer_settime (timer_t timerid, int flags,
 int timer_gettime (timer_t timerid, struct itimerspec *value);
 int timer_getoverrun (timer_t timerid);
 
-/* High Resolution Sleep, P1003.1b-1993, p. 269 */
-
-int nanosleep (const struct timespec  *rqtp, struct timespec *rmtp);
-
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,37 @@
+/* Copyright (C) SoCHub Finland 2024
+
+   This copyrighted material is made available to anyone wishing to use,
+   modify, copy, or redistribute it subject to the terms and conditions
+   of the FreeBSD License.   This program is distributed in the hope that
+   it will be useful, but WITHOUT ANY WARRANTY expressed or implied,
+   including the implied warranties of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  A copy of this license is available at
+   http://www.opensource.org/licenses.
+*/
+
+/* Per-hart reentrancy structure.
+
+   Every hart gets its own struct _reent as a thread-local object.  The
+   runtime (libgloss crt0) gives each hart a copy of the TLS template and
+   points tp at it, so __getreent is a single tp-relative address
+   computation and needs no lock.  errno, strtok state and the other
+   members of struct _reent are then private to a hart.  The standard
+   streams themselves stay global and shared between harts.  */
+
+#include <reent.h>
+
+#if defined(__DYNAMIC_REENT__) && !defined(__SINGLE_THREAD__)
+
+#ifdef __getreent
+#undef __getreent
+#endif
+
+static __thread struct _reent __hart_reent = _REENT_INIT (__hart_reent);
+
+struct _reent *
+__getreent (void)
+{
+  return &__hart_reent;
+}
+
+#endif
@@ -0,0 +1,204 @@
+/* Copyright (C) SoCHub Finland 2024
+
+   This copyrighted material is made available to anyone wishing to use,
+   modify, copy, or redistribute it subject to the terms and conditions
+   of the FreeBSD License.   This program is distributed in the hope that
+   it will be useful, but WITHOUT ANY WARRANTY expressed or implied,
+   including the implied warranties of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  A copy of this license is available at
+   http://www.opensource.org/licenses.
+*/
+
+/* Retargetable locks for several harts sharing one newlib.
+
+   Plain locks are test-and-test-and-set spinlocks: a hart that finds
+   the lock taken spins on an ordinary load, which stays in its own cache,
+   and only retries the amoswap once the lock looks free.  Recursive locks
+   hand out tickets with amoadd and are served in order, so a hart
+   hammering malloc cannot starve the others; the owner is identified by
+   its tp, which is unique per hart (see getreent.c).
+
+   Every lock counts the acquisitions that had to wait.  The counts are
+   read with __retarget_lock_contention () from <machine/lockstat.h>.
+
+   Without the A extension there is a single hart and the AMOs become
+   ordinary loads and stores.  */
+
+#include <newlib.h>
+#include <stdlib.h>
+#include <sys/lock.h>
+
+#if defined(_RETARGETABLE_LOCKING) && !defined(__SINGLE_THREAD__) \
+    && defined(RETARGET_LOCK_PROVIDED)
+
+#include <machine/lockstat.h>
+
+struct __lock {
+  unsigned int next;		/* Flag (plain) or next ticket (recursive) */
+  unsigned int serving;		/* Ticket being served (recursive) */
+  void *owner;			/* tp of the holder (recursive) */
+  unsigned int depth;		/* Nesting count of the holder (recursive) */
+  unsigned long contended;	/* Acquisitions that had to wait */
+};
+
+struct __lock __lock___sfp_recursive_mutex;
+struct __lock __lock___atexit_recursive_mutex;
+struct __lock __lock___at_quick_exit_mutex;
+struct __lock __lock___malloc_recursive_mutex;
+struct __lock __lock___env_recursive_mutex;
+struct __lock __lock___tz_mutex;
+struct __lock __lock___dd_hash_mutex;
+struct __lock __lock___arc4random_mutex;
+
+#ifdef __riscv_atomic
+#define LOCK_SWAP(p, v)		__atomic_exchange_n (p, v, __ATOMIC_ACQUIRE)
+#define LOCK_FETCH_ADD(p, v)	__atomic_fetch_add (p, v, __ATOMIC_RELAXED)
+#define LOCK_LOAD(p)		__atomic_load_n (p, __ATOMIC_ACQUIRE)
+#define LOCK_PEEK(p)		__atomic_load_n (p, __ATOMIC_RELAXED)
+#define LOCK_STORE(p, v)	__atomic_store_n (p, v, __ATOMIC_RELEASE)
+#define LOCK_CAS(p, old, v)	__atomic_compare_exchange_n (p, &(old), v, 0, \
+				  __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)
+#else
+#define LOCK_SWAP(p, v) \
+  ({ __typeof__ (*(p)) __old = *(p); *(p) = (v); __old; })
+#define LOCK_FETCH_ADD(p, v) \
+  ({ __typeof__ (*(p)) __old = *(p); *(p) = __old + (v); __old; })
+#define LOCK_CAS(p, old, v) \
+  (*(p) == (old) ? (*(p) = (v), 1) : 0)
+#define LOCK_LOAD(p)		(*(volatile __typeof__ (*(p)) *) (p))
+#define LOCK_PEEK(p)		LOCK_LOAD (p)
+#define LOCK_STORE(p, v)	(*(volatile __typeof__ (*(p)) *) (p) = (v))
+#endif
+
+/* Zihintpause PAUSE, a FENCE hint that older cores execute as a no-op.  */
+#define cpu_relax()	__asm__ volatile (".insn i 0x0f, 0, x0, x0, 0x010")
+
+static inline void *
+lock_self (void)
+{
+  void *tp;
+
+  __asm__ ("mv %0, tp" : "=r" (tp));
+  return tp;
+}
+
+void
+__retarget_lock_init (_LOCK_T *lock)
+{
+  *lock = calloc (1, sizeof (struct __lock));
+}
+
+void
+__retarget_lock_init_recursive (_LOCK_T *lock)
+{
+  *lock = calloc (1, sizeof (struct __lock));
+}
+
+void
+__retarget_lock_close (_LOCK_T lock)
+{
+  free (lock);
+}
+
+void
+__retarget_lock_close_recursive (_LOCK_T lock)
+{
+  free (lock);
+}
+
+void
+__retarget_lock_acquire (_LOCK_T lock)
+{
+  if (lock == NULL)
+    return;
+  if (LOCK_SWAP (&lock->next, 1) == 0)
+    return;
+
+  LOCK_FETCH_ADD (&lock->contended, 1);
+  do
+    while (LOCK_PEEK (&lock->next))
+      cpu_relax ();
+  while (LOCK_SWAP (&lock->next, 1));
+}
+
+int
+__retarget_lock_try_acquire (_LOCK_T lock)
+{
+  if (lock == NULL)
+    return 0;
+  if (LOCK_PEEK (&lock->next) || LOCK_SWAP (&lock->next, 1))
+    return 1;
+  return 0;
+}
+
+void
+__retarget_lock_release (_LOCK_T lock)
+{
+  if (lock != NULL)
+    LOCK_STORE (&lock->next, 0);
+}
+
+void
+__retarget_lock_acquire_recursive (_LOCK_T lock)
+{
+  void *self = lock_self ();
+  unsigned int ticket;
+
+  if (lock == NULL)
+    return;
+  if (lock->owner == self)
+    {
+      lock->depth++;
+      return;
+    }
+
+  ticket = LOCK_FETCH_ADD (&lock->next, 1);
+  if (LOCK_LOAD (&lock->serving) != ticket)
+    {
+      LOCK_FETCH_ADD (&lock->contended, 1);
+      while (LOCK_LOAD (&lock->serving) != ticket)
+	cpu_relax ();
+    }
+  lock->owner = self;
+  lock->depth = 1;
+}
+
+int
+__retarget_lock_try_acquire_recursive (_LOCK_T lock)
+{
+  void *self = lock_self ();
+  unsigned int ticket;
+
+  if (lock == NULL)
+    return 0;
+  if (lock->owner == self)
+    {
+      lock->depth++;
+      return 0;
+    }
+
+  /* Take a ticket only if it would be served at once.  */
+  ticket = LOCK_LOAD (&lock->serving);
+  if (!LOCK_CAS (&lock->next, ticket, ticket + 1))
+    return 1;
+  lock->owner = self;
+  lock->depth = 1;
+  return 0;
+}
+
+void
+__retarget_lock_release_recursive (_LOCK_T lock)
+{
+  if (lock == NULL || --lock->depth != 0)
+    return;
+  lock->owner = NULL;
+  LOCK_STORE (&lock->serving, lock->serving + 1);
+}
+
+unsigned long
+__retarget_lock_contention (_LOCK_T lock)
+{
+  return lock != NULL ? LOCK_PEEK (&lock->contended) : 0;
+}
+
+#endif
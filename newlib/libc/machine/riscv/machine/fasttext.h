@@ -0,0 +1,74 @@
+/* Copyright (C) SoCHub Finland 2024
+
+   This copyrighted material is made available to anyone wishing to use,
+   modify, copy, or redistribute it subject to the terms and conditions
+   of the FreeBSD License.   This program is distributed in the hope that
+   it will be useful, but WITHOUT ANY WARRANTY expressed or implied,
+   including the implied warranties of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  A copy of this license is available at
+   http://www.opensource.org/licenses.
+*/
+
+/* Placement of hot library routines in fast instruction memory.
+
+   _FAST_TEXT (name) in front of a function definition puts the function
+   into the .fast_text.name section; assembler sources use
+   _FAST_TEXT_SECTION (name) instead of .text.  The libgloss linker
+   script gives .fast_text its run address in scratchpad RAM and crt0
+   copies it there before any call, so the calls go straight to the RAM
+   copies.  Without a scratchpad the section runs where it is loaded.
+
+   The routines marked in newlib are memcpy, memset, strlen, vfprintf
+   (the formatting core of all printf variants), malloc and free (nano
+   malloc).  Each is placed when _FAST_TEXT_name is 1, which defaults to
+   _FAST_TEXT_DEFAULT (1).  Build newlib with, for example,
+   CFLAGS_FOR_TARGET="-D_FAST_TEXT_vfprintf=0" to leave a routine in
+   .text, or with -D_FAST_TEXT_DEFAULT=0 -D_FAST_TEXT_memcpy=1 to place
+   only the ones named.  */
+
+#ifndef _MACHINE_FASTTEXT_H
+#define _MACHINE_FASTTEXT_H
+
+#ifndef _FAST_TEXT_DEFAULT
+#define _FAST_TEXT_DEFAULT	1
+#endif
+
+#ifndef _FAST_TEXT_memcpy
+#define _FAST_TEXT_memcpy	_FAST_TEXT_DEFAULT
+#endif
+#ifndef _FAST_TEXT_memset
+#define _FAST_TEXT_memset	_FAST_TEXT_DEFAULT
+#endif
+#ifndef _FAST_TEXT_strlen
+#define _FAST_TEXT_strlen	_FAST_TEXT_DEFAULT
+#endif
+#ifndef _FAST_TEXT_vfprintf
+#define _FAST_TEXT_vfprintf	_FAST_TEXT_DEFAULT
+#endif
+#ifndef _FAST_TEXT_malloc
+#define _FAST_TEXT_malloc	_FAST_TEXT_DEFAULT
+#endif
+#ifndef _FAST_TEXT_free
+#define _FAST_TEXT_free		_FAST_TEXT_DEFAULT
+#endif
+
+/* _FAST_TEXT_name is expanded to 0 or 1 before it is pasted */
+#define __FAST_TEXT(on, name)		__FAST_TEXT_(on, name)
+#define __FAST_TEXT_(on, name)		__FAST_TEXT_##on(name)
+#define __FAST_TEXT_1(name)						\
+  __attribute__ ((__section__ (".fast_text." #name)))
+#define __FAST_TEXT_0(name)
+
+#define _FAST_TEXT(name)		__FAST_TEXT (_FAST_TEXT_##name, name)
+
+#ifdef __ASSEMBLER__
+#define __FAST_TEXT_SECTION(on, name)	__FAST_TEXT_SECTION_(on, name)
+#define __FAST_TEXT_SECTION_(on, name)	__FAST_TEXT_SECTION_##on(name)
+#define __FAST_TEXT_SECTION_1(name)					\
+  .section .fast_text.name, "ax", @progbits; .p2align 2
+#define __FAST_TEXT_SECTION_0(name)	.text
+
+#define _FAST_TEXT_SECTION(name)	__FAST_TEXT_SECTION (_FAST_TEXT_##name, name)
+#endif
+
+#endif /* _MACHINE_FASTTEXT_H */
@@ -0,0 +1,48 @@
+/* Copyright (C) SoCHub Finland 2024
+
+   This copyrighted material is made available to anyone wishing to use,
+   modify, copy, or redistribute it subject to the terms and conditions
+   of the FreeBSD License.   This program is distributed in the hope that
+   it will be useful, but WITHOUT ANY WARRANTY expressed or implied,
+   including the implied warranties of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  A copy of this license is available at
+   http://www.opensource.org/licenses.
+*/
+
+/* Contention statistics of the RISC-V retarget locks.
+
+   __retarget_lock_contention () returns how many acquisitions of a lock
+   found it held by another hart and had to spin.  The static locks of
+   the library are declared below, so that an application can report
+   for example how often harts collided in malloc:
+
+     __retarget_lock_contention (&__lock___malloc_recursive_mutex)
+
+   Only available when newlib is configured with
+   --enable-newlib-retargetable-locking and multithread support.  */
+
+#ifndef _MACHINE_LOCKSTAT_H
+#define _MACHINE_LOCKSTAT_H
+
+#include <sys/lock.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+unsigned long __retarget_lock_contention (_LOCK_T __lock);
+
+extern struct __lock __lock___sfp_recursive_mutex;
+extern struct __lock __lock___atexit_recursive_mutex;
+extern struct __lock __lock___at_quick_exit_mutex;
+extern struct __lock __lock___malloc_recursive_mutex;
+extern struct __lock __lock___env_recursive_mutex;
+extern struct __lock __lock___tz_mutex;
+extern struct __lock __lock___dd_hash_mutex;
+extern struct __lock __lock___arc4random_mutex;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MACHINE_LOCKSTAT_H */
@@ -11,7 +11,9 @@
 
 #include <string.h>
 #include <stdint.h>
+#include <machine/fasttext.h>
 
+_FAST_TEXT (strlen)
 size_t strlen(const char *str)
 {
   const char *start = str;
@@ -30,6 +32,13 @@ size_t strlen(const char *str)
     } while ((uintptr_t)str & (sizeof (long) - 1));
 
   unsigned long *ls = (unsigned long *)str;
+#ifdef __riscv_zbb
+  /* The first zero byte is the lowest one marked, ctz finds it */
+  unsigned long nul;
+  while (!(nul = __libc_detect_null (*ls)))
+    ls++;
+  return (const char *)ls - start + (__builtin_ctzl (nul) >> 3);
+#else
   while (!__libc_detect_null (*ls++))
     ;
   asm volatile ("" : "+r"(ls)); /* prevent "optimization" */
@@ -49,5 +58,6 @@ size_t strlen(const char *str)
   if (c2 == 0)            return ret + 6 - sl;
 
   return ret + 7 - sl;
+#endif /* not __riscv_zbb */
 #endif /* not PREFER_SIZE_OVER_SPEED */
 }
@@ -12,12 +12,20 @@
 #ifndef _SYS_STRING_H
 #define _SYS_STRING_H
 
+/* Nonzero if w has a zero byte: the zero bytes have their top bit set
+   (all bits with Zbb), the others are clear.  */
 static __inline unsigned long __libc_detect_null(unsigned long w)
 {
+#ifdef __riscv_zbb
+  unsigned long r;
+  __asm__ ("orc.b %0, %1" : "=r" (r) : "r" (w));
+  return ~r;
+#else
   unsigned long mask = 0x7f7f7f7f;
   if (sizeof (long) == 8)
     mask = ((mask << 16) << 16) | mask;
   return ~(((w & mask) + mask) | w | mask);
+#endif
 }
 
 #endif
@@ -81,7 +81,12 @@ subroutines are required for linking multi-threaded applications.
 
 /* dummy lock routines and static locks for single-threaded apps */
 
-#ifndef __SINGLE_THREAD__
+#ifdef RETARGET_LOCK_PROVIDED
+
+/* The target provides the locks; keep this unit non-empty for ISO C */
+static int _dummy_lock __attribute__ ((__unused__));
+
+#elif !defined(__SINGLE_THREAD__)
 
 #include <sys/lock.h>
 
@@ -167,6 +167,7 @@ static char *rcsid = "$Id$";
 #include "fvwrite.h"
 #include "vfieeefp.h"
 #include "nano-vfprintf_local.h"
+#include <machine/fasttext.h>
 
 /* The __ssputs_r function is shared between all versions of vfprintf
    and vfwprintf.  */
@@ -464,6 +465,7 @@ vfiprintf (FILE *, const char *, __VALIST)
 # define FLUSH()
 #endif
 
+_FAST_TEXT (vfprintf)
 int
 _VFPRINTF_R (struct _reent *data,
        FILE * fp,
@@ -43,6 +43,7 @@
 #include "fvwrite.h"
 #include "vfieeefp.h"
 #include "nano-vfprintf_local.h"
+#include <machine/fasttext.h>
 
 /* Decode and print non-floating point data.  */
 int
@@ -104,6 +105,7 @@ _printf_common (struct _reent *data,
 error:
   return -1;
 }
+_FAST_TEXT (vfprintf)
 int
 _printf_i (struct _reent *data, struct _prt_data_t *pdata, FILE *fp,
 	   int (*pfunc)(struct _reent *, FILE *, const char *, size_t len),
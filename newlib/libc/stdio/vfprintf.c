@@ -158,6 +158,7 @@ static char *rcsid = "$Id$";
 #include "../stdlib/local.h"
 #include "fvwrite.h"
 #include "vfieeefp.h"
+#include <machine/fasttext.h>
 
 /* Currently a test is made to see if long double processing is warranted.
    This could be changed in the future should the _ldtoa_r code be
@@ -400,6 +401,7 @@ VFPRINTF (FILE * fp,
 }
 #endif /* STRING_ONLY */
 
+_FAST_TEXT (vfprintf)
 int
 _VFPRINTF_R (struct _reent *data,
        FILE * fp,
@@ -37,6 +37,7 @@
 #include <errno.h>
 #include <malloc.h>
 #include <stdint.h>
+#include <machine/fasttext.h>
 
 #if DEBUG
 #include <assert.h>
@@ -235,6 +236,7 @@ static void* sbrk_aligned(RARG malloc_size_t s)
   *   Walk through the free list to find the first match. If fails to find
   *   one, call sbrk to allocate a new chunk.
   */
+_FAST_TEXT (malloc)
 void * nano_malloc(RARG malloc_size_t s)
 {
     chunk *p, *r;
@@ -413,6 +415,7 @@ void * nano_malloc(RARG malloc_size_t s)
   *  insert should make sure all chunks are sorted by address from low to
   *  high.  Then merge with neighbor chunks if adjacent.
   */
+_FAST_TEXT (free)
 void nano_free (RARG void * free_p)
 {
     chunk * p_to_free;